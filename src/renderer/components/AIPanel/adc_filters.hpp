@@ -0,0 +1,256 @@
+//写一个test.c里ADC滤波的C++头文件模板版本，按采样类型、累加类型和窗口大小特化
+//窗口是编译期常量，固定窗口的循环可以被展开，2的幂窗口的除法直接变成移位，状态大小也是静态的
+//取整规则与test.c完全一致：均值向零截断，方差以截断后的整数均值为中心
+//C++固件如果不编译test.c，可以在一个.cpp里先定义ADC_FILTERS_DEFINE_C_API再包含本文件，
+//adc_mean_filter等C接口就由下面的模板实例化提供
+#ifndef ADC_FILTERS_HPP
+#define ADC_FILTERS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace adc {
+
+template <std::size_t N>
+constexpr bool is_power_of_two = N != 0 && (N & (N - 1)) == 0;
+
+template <std::size_t N>
+constexpr unsigned log2_of() {
+    unsigned bits = 0;
+    while ((std::size_t{1} << bits) < N) {
+        bits++;
+    }
+    return bits;
+}
+
+//除以编译期常量：无符号累加且N为2的幂时用移位，有符号时保持向零截断(编译器会生成移位加修正)
+template <std::size_t N, typename Accum>
+constexpr Accum divide(Accum value) {
+    if constexpr (std::is_unsigned_v<Accum> && is_power_of_two<N>) {
+        return static_cast<Accum>(value >> log2_of<N>());
+    } else {
+        return static_cast<Accum>(value / static_cast<Accum>(N));
+    }
+}
+
+//运行时长度的版本，供C接口实例化
+template <typename Sample, typename Accum>
+Accum sum(const Sample *values, std::size_t length) {
+    Accum total = 0;
+    for (std::size_t i = 0; i < length; i++) {
+        total += static_cast<Accum>(values[i]);
+    }
+    return total;
+}
+
+template <typename Sample, typename Accum>
+int mean(const Sample *values, std::size_t length) {
+    return static_cast<int>(sum<Sample, Accum>(values, length) / static_cast<Accum>(length));
+}
+
+template <typename Sample, typename Accum>
+int variance(const Sample *values, std::size_t length) {
+    Accum m = static_cast<Accum>(mean<Sample, Accum>(values, length));
+    Accum total = 0;
+    for (std::size_t i = 0; i < length; i++) {
+        Accum deviation = static_cast<Accum>(values[i]) - m;
+        total += deviation * deviation;
+    }
+    return static_cast<int>(total / static_cast<Accum>(length));
+}
+
+//与adc_median_filter一样原地重排，返回排序后下标length/2处的值
+template <typename Sample>
+int median(Sample *values, std::size_t length) {
+    std::nth_element(values, values + length / 2, values + length);
+    return static_cast<int>(values[length / 2]);
+}
+
+template <typename Sample, typename Accum>
+int adaptive_threshold(const Sample *values, std::size_t length) {
+    Accum m = static_cast<Accum>(mean<Sample, Accum>(values, length));
+    Accum total = 0;
+    for (std::size_t i = 0; i < length; i++) {
+        if (static_cast<Accum>(values[i]) > m) {
+            total += static_cast<Accum>(values[i]);
+        }
+    }
+    return static_cast<int>(total / static_cast<Accum>(length));
+}
+
+//固定窗口的滑动缓存，push返回被挤出的旧采样(未满时为0)
+template <typename Sample, std::size_t Window>
+class WindowBuffer {
+public:
+    static_assert(Window > 0, "window must not be empty");
+
+    Sample push(Sample value) {
+        Sample leaving = samples_[head_];
+        samples_[head_] = value;
+        head_ = head_ + 1 == Window ? 0 : head_ + 1;
+        if (count_ < Window) {
+            count_++;
+            leaving = 0;
+        }
+        return leaving;
+    }
+
+    bool full() const { return count_ == Window; }
+    std::size_t size() const { return count_; }
+    const std::array<Sample, Window> &samples() const { return samples_; }
+
+private:
+    std::array<Sample, Window> samples_{};
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+};
+
+//滑动均值：push一个采样O(1)更新，compute对恰好Window个采样的块求均值(循环可完全展开)
+template <typename Sample, typename Accum, std::size_t Window>
+class MeanFilter {
+public:
+    static int compute(const Sample *values) {
+        Accum total = 0;
+        for (std::size_t i = 0; i < Window; i++) {
+            total += static_cast<Accum>(values[i]);
+        }
+        return static_cast<int>(divide<Window>(total));
+    }
+
+    //窗口未满时返回已有采样的均值
+    int push(Sample value) {
+        sum_ += static_cast<Accum>(value);
+        sum_ -= static_cast<Accum>(window_.push(value));
+        if (window_.full()) {
+            return static_cast<int>(divide<Window>(sum_));
+        }
+        return static_cast<int>(sum_ / static_cast<Accum>(window_.size()));
+    }
+
+private:
+    WindowBuffer<Sample, Window> window_;
+    Accum sum_ = 0;
+};
+
+//滑动方差：维护和与平方和，结果与adc_variance_filter对同一窗口的结果一致
+template <typename Sample, typename Accum, std::size_t Window>
+class VarianceFilter {
+public:
+    static int compute(const Sample *values) {
+        Accum m = static_cast<Accum>(MeanFilter<Sample, Accum, Window>::compute(values));
+        Accum total = 0;
+        for (std::size_t i = 0; i < Window; i++) {
+            Accum deviation = static_cast<Accum>(values[i]) - m;
+            total += deviation * deviation;
+        }
+        return static_cast<int>(divide<Window>(total));
+    }
+
+    int push(Sample value) {
+        Accum entering = static_cast<Accum>(value);
+        Accum leaving = static_cast<Accum>(window_.push(value));
+        sum_ += entering - leaving;
+        sum_squares_ += entering * entering - leaving * leaving;
+        Accum n = static_cast<Accum>(window_.size());
+        Accum m = sum_ / n;
+        return static_cast<int>((sum_squares_ - 2 * m * sum_ + n * m * m) / n);
+    }
+
+private:
+    WindowBuffer<Sample, Window> window_;
+    Accum sum_ = 0;
+    Accum sum_squares_ = 0;
+};
+
+template <typename Sample, typename Accum, std::size_t Window>
+class StandardDeviationFilter {
+public:
+    static int compute(const Sample *values) {
+        return static_cast<int>(std::sqrt(VarianceFilter<Sample, Accum, Window>::compute(values)));
+    }
+
+    int push(Sample value) { return static_cast<int>(std::sqrt(variance_.push(value))); }
+
+private:
+    VarianceFilter<Sample, Accum, Window> variance_;
+};
+
+//滑动中值：每次在窗口副本上nth_element，窗口很小时比维护有序结构更快
+template <typename Sample, std::size_t Window>
+class MedianFilter {
+public:
+    static int compute(const Sample *values) {
+        std::array<Sample, Window> copy;
+        std::copy(values, values + Window, copy.begin());
+        return median(copy.data(), Window);
+    }
+
+    int push(Sample value) {
+        window_.push(value);
+        std::array<Sample, Window> copy = window_.samples();
+        return median(copy.data(), window_.size());
+    }
+
+private:
+    WindowBuffer<Sample, Window> window_;
+};
+
+template <typename Sample, typename Accum, std::size_t Window>
+class AdaptiveThreshold {
+public:
+    static int compute(const Sample *values) {
+        Accum m = static_cast<Accum>(MeanFilter<Sample, Accum, Window>::compute(values));
+        Accum total = 0;
+        for (std::size_t i = 0; i < Window; i++) {
+            if (static_cast<Accum>(values[i]) > m) {
+                total += static_cast<Accum>(values[i]);
+            }
+        }
+        return static_cast<int>(divide<Window>(total));
+    }
+};
+
+}  // namespace adc
+
+#ifdef ADC_FILTERS_DEFINE_C_API
+//test.c里C接口的模板实例化版本，签名和结果与test.c一致
+extern "C" {
+int adc_mean_filter(int *adc_values, int length) {
+    return adc::mean<int, std::int64_t>(adc_values, static_cast<std::size_t>(length));
+}
+
+int adc_median_filter(int *adc_values, int length) {
+    return adc::median(adc_values, static_cast<std::size_t>(length));
+}
+
+int adc_variance_filter(int *adc_values, int length) {
+    return adc::variance<int, std::int64_t>(adc_values, static_cast<std::size_t>(length));
+}
+
+int adc_standard_deviation_filter(int *adc_values, int length) {
+    return static_cast<int>(std::sqrt(adc_variance_filter(adc_values, length)));
+}
+
+int adaptive_threshold_algorithm(int *adc_values, int length) {
+    return adc::adaptive_threshold<int, std::int64_t>(adc_values, static_cast<std::size_t>(length));
+}
+
+int adc_mean_filter_u16(const std::uint16_t *adc_values, int length) {
+    return adc::mean<std::uint16_t, std::uint64_t>(adc_values, static_cast<std::size_t>(length));
+}
+
+int adc_variance_filter_u16(const std::uint16_t *adc_values, int length) {
+    return adc::variance<std::uint16_t, std::int64_t>(adc_values, static_cast<std::size_t>(length));
+}
+
+int adc_median_filter_u16(std::uint16_t *adc_values, int length) {
+    return adc::median(adc_values, static_cast<std::size_t>(length));
+}
+}
+#endif
+
+#endif
@@ -0,0 +1,307 @@
+//写一个编译期的滤波器系数生成头文件：窗函数sinc FIR(Hamming/Blackman/Kaiser)和RBJ cookbook二阶节
+//给出采样率和截止频率，在编译期算出Q15/Q31定点系数，不再需要Python脚本或运行时三角函数，flash里的表和设计参数始终一致
+//三角、指数、对数、Bessel I0都是这里的constexpr级数实现，|x| <= pi时sin/cos误差在1e-15量级，量化后与离线计算的表逐位相同
+//Q31二阶节的布局与test.c的adc_biquad_coeffs_t一致(b0, b1, b2, a1, a2，y = b0x + b1x1 + b2x2 - a1y1 - a2y2)
+//用法：constexpr auto taps = adc::design::to_q15(adc::design::fir_lowpass<31>(1000.0, 50.0, adc::design::Window::Blackman));
+#ifndef FILTER_DESIGN_HPP
+#define FILTER_DESIGN_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace adc {
+namespace design {
+
+constexpr double pi = 3.14159265358979323846;
+
+namespace detail {
+
+constexpr double abs(double x) { return x < 0 ? -x : x; }
+
+//先把角度规约到[-pi, pi]，再用泰勒级数
+constexpr double reduce_angle(double x) {
+    double turns = x / (2 * pi);
+    long long whole = static_cast<long long>(turns < 0 ? turns - 0.5 : turns + 0.5);
+    return x - static_cast<double>(whole) * 2 * pi;
+}
+
+constexpr double sin(double x) {
+    x = reduce_angle(x);
+    double term = x;
+    double total = x;
+    for (int k = 1; k < 30; k++) {
+        term *= -x * x / ((2 * k) * (2 * k + 1));
+        total += term;
+    }
+    return total;
+}
+
+constexpr double cos(double x) {
+    x = reduce_angle(x);
+    double term = 1;
+    double total = 1;
+    for (int k = 1; k < 30; k++) {
+        term *= -x * x / ((2 * k - 1) * (2 * k));
+        total += term;
+    }
+    return total;
+}
+
+constexpr double sqrt(double x) {
+    if (x <= 0) {
+        return 0;
+    }
+    double guess = x < 1 ? 1 : x;
+    for (int i = 0; i < 100; i++) {
+        double next = 0.5 * (guess + x / guess);
+        if (next == guess) {
+            break;
+        }
+        guess = next;
+    }
+    return guess;
+}
+
+//exp：按2的幂缩小到|x| <= 0.5后用级数，再平方回去
+constexpr double exp(double x) {
+    int squarings = 0;
+    while (abs(x) > 0.5) {
+        x *= 0.5;
+        squarings++;
+    }
+    double term = 1;
+    double total = 1;
+    for (int k = 1; k < 25; k++) {
+        term *= x / k;
+        total += term;
+    }
+    for (int i = 0; i < squarings; i++) {
+        total *= total;
+    }
+    return total;
+}
+
+//log：把x缩放到[0.5, 1)，ln(m) = 2 * atanh((m - 1) / (m + 1))
+constexpr double log(double x) {
+    int exponent = 0;
+    while (x >= 1) {
+        x *= 0.5;
+        exponent++;
+    }
+    while (x < 0.5) {
+        x *= 2;
+        exponent--;
+    }
+    double z = (x - 1) / (x + 1);
+    double term = z;
+    double total = 0;
+    for (int k = 1; k < 80; k += 2) {
+        total += term / k;
+        term *= z * z;
+    }
+    return 2 * total + exponent * 0.69314718055994530942;
+}
+
+constexpr double pow(double base, double exponent) { return base <= 0 ? 0 : exp(exponent * log(base)); }
+
+//第一类零阶修正Bessel函数，级数在Kaiser常用的beta < 20内很快收敛
+constexpr double bessel_i0(double x) {
+    double term = 1;
+    double total = 1;
+    for (int k = 1; k < 60; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        total += term;
+    }
+    return total;
+}
+
+constexpr double sinc(double x) { return x == 0 ? 1 : sin(pi * x) / (pi * x); }
+
+}  // namespace detail
+
+enum class Window { Hamming, Blackman, Kaiser };
+
+//Kaiser窗的beta：按期望阻带衰减(dB)估算，Kaiser经验公式
+constexpr double kaiser_beta(double attenuation_db) {
+    if (attenuation_db > 50) {
+        return 0.1102 * (attenuation_db - 8.7);
+    }
+    if (attenuation_db >= 21) {
+        return 0.5842 * detail::pow(attenuation_db - 21, 0.4) + 0.07886 * (attenuation_db - 21);
+    }
+    return 0;
+}
+
+constexpr double window_value(Window window, std::size_t n, std::size_t length, double beta) {
+    if (length == 1) {
+        return 1;
+    }
+    double phase = 2 * pi * static_cast<double>(n) / static_cast<double>(length - 1);
+    switch (window) {
+    case Window::Hamming:
+        return 0.54 - 0.46 * detail::cos(phase);
+    case Window::Blackman:
+        return 0.42 - 0.5 * detail::cos(phase) + 0.08 * detail::cos(2 * phase);
+    case Window::Kaiser: {
+        double r = 2.0 * static_cast<double>(n) / static_cast<double>(length - 1) - 1;
+        return detail::bessel_i0(beta * detail::sqrt(1 - r * r)) / detail::bessel_i0(beta);
+    }
+    }
+    return 1;
+}
+
+//理想低通的加窗截断，归一化为直流增益1
+template <std::size_t N>
+constexpr std::array<double, N> fir_lowpass(double sample_rate, double cutoff, Window window = Window::Hamming, double beta = 0) {
+    static_assert(N > 0, "filter needs at least one tap");
+    std::array<double, N> taps{};
+    double fc = cutoff / sample_rate;
+    double centre = static_cast<double>(N - 1) / 2;
+    double total = 0;
+    for (std::size_t n = 0; n < N; n++) {
+        taps[n] = 2 * fc * detail::sinc(2 * fc * (static_cast<double>(n) - centre)) * window_value(window, n, N, beta);
+        total += taps[n];
+    }
+    for (std::size_t n = 0; n < N; n++) {
+        taps[n] /= total;
+    }
+    return taps;
+}
+
+//谱反转得到高通，奇数长度才有整数延迟的中心抽头
+template <std::size_t N>
+constexpr std::array<double, N> fir_highpass(double sample_rate, double cutoff, Window window = Window::Hamming, double beta = 0) {
+    static_assert(N % 2 == 1, "high-pass FIR needs an odd tap count");
+    std::array<double, N> taps = fir_lowpass<N>(sample_rate, cutoff, window, beta);
+    for (std::size_t n = 0; n < N; n++) {
+        taps[n] = -taps[n];
+    }
+    taps[N / 2] += 1;
+    return taps;
+}
+
+//两个低通相减，再按通带中心频率处的增益归一化为1
+template <std::size_t N>
+constexpr std::array<double, N> fir_bandpass(double sample_rate, double low, double high, Window window = Window::Hamming, double beta = 0) {
+    std::array<double, N> taps{};
+    double centre = static_cast<double>(N - 1) / 2;
+    double f1 = low / sample_rate;
+    double f2 = high / sample_rate;
+    double w0 = pi * (f1 + f2);
+    double gain = 0;
+    for (std::size_t n = 0; n < N; n++) {
+        double t = static_cast<double>(n) - centre;
+        taps[n] = (2 * f2 * detail::sinc(2 * f2 * t) - 2 * f1 * detail::sinc(2 * f1 * t)) * window_value(window, n, N, beta);
+        gain += taps[n] * detail::cos(w0 * t);
+    }
+    for (std::size_t n = 0; n < N; n++) {
+        taps[n] /= gain;
+    }
+    return taps;
+}
+
+//四舍五入到frac_bits位小数并对称饱和：不产生最小负数，Q15 FIR(adc_fir_q15_init)不接受-32768
+template <typename Int>
+constexpr Int to_fixed(double value, unsigned frac_bits) {
+    double scaled = value * static_cast<double>(1ULL << frac_bits);
+    double limit = static_cast<double>(std::numeric_limits<Int>::max());
+    scaled = scaled > limit ? limit : scaled < -limit ? -limit : scaled;
+    return static_cast<Int>(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+template <std::size_t N>
+constexpr std::array<std::int16_t, N> to_q15(const std::array<double, N> &taps) {
+    std::array<std::int16_t, N> fixed{};
+    for (std::size_t n = 0; n < N; n++) {
+        fixed[n] = to_fixed<std::int16_t>(taps[n], 15);
+    }
+    return fixed;
+}
+
+template <std::size_t N>
+constexpr std::array<std::int32_t, N> to_q31(const std::array<double, N> &taps) {
+    std::array<std::int32_t, N> fixed{};
+    for (std::size_t n = 0; n < N; n++) {
+        fixed[n] = to_fixed<std::int32_t>(taps[n], 31);
+    }
+    return fixed;
+}
+
+//RBJ cookbook二阶节，已除以a0
+struct Biquad {
+    double b0, b1, b2, a1, a2;
+};
+
+//与adc_biquad_coeffs_t同布局的定点系数
+struct BiquadQ31 {
+    std::int32_t b0, b1, b2, a1, a2;
+};
+
+constexpr Biquad normalize(double b0, double b1, double b2, double a0, double a1, double a2) {
+    return Biquad{b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+}
+
+constexpr Biquad rbj_lowpass(double sample_rate, double f0, double q) {
+    double w0 = 2 * pi * f0 / sample_rate;
+    double c = detail::cos(w0);
+    double alpha = detail::sin(w0) / (2 * q);
+    return normalize((1 - c) / 2, 1 - c, (1 - c) / 2, 1 + alpha, -2 * c, 1 - alpha);
+}
+
+constexpr Biquad rbj_highpass(double sample_rate, double f0, double q) {
+    double w0 = 2 * pi * f0 / sample_rate;
+    double c = detail::cos(w0);
+    double alpha = detail::sin(w0) / (2 * q);
+    return normalize((1 + c) / 2, -(1 + c), (1 + c) / 2, 1 + alpha, -2 * c, 1 - alpha);
+}
+
+//带通，峰值增益0 dB
+constexpr Biquad rbj_bandpass(double sample_rate, double f0, double q) {
+    double w0 = 2 * pi * f0 / sample_rate;
+    double c = detail::cos(w0);
+    double alpha = detail::sin(w0) / (2 * q);
+    return normalize(alpha, 0, -alpha, 1 + alpha, -2 * c, 1 - alpha);
+}
+
+constexpr Biquad rbj_notch(double sample_rate, double f0, double q) {
+    double w0 = 2 * pi * f0 / sample_rate;
+    double c = detail::cos(w0);
+    double alpha = detail::sin(w0) / (2 * q);
+    return normalize(1, -2 * c, 1, 1 + alpha, -2 * c, 1 - alpha);
+}
+
+//量化到Q(31 - post_shift)，与adc_biquad_df1_init的post_shift参数对应；post_shift=1时系数范围[-2, 2)
+constexpr BiquadQ31 to_q31(const Biquad &biquad, unsigned post_shift = 1) {
+    unsigned bits = 31 - post_shift;
+    return BiquadQ31{to_fixed<std::int32_t>(biquad.b0, bits), to_fixed<std::int32_t>(biquad.b1, bits),
+                     to_fixed<std::int32_t>(biquad.b2, bits), to_fixed<std::int32_t>(biquad.a1, bits),
+                     to_fixed<std::int32_t>(biquad.a2, bits)};
+}
+
+//2*Sections阶Butterworth拆成Sections个二阶节，Q_k = 1 / (2cos((2k + 1)pi / (4 * Sections)))，Q小的节在前
+template <std::size_t Sections>
+constexpr std::array<BiquadQ31, Sections> butterworth_lowpass_q31(double sample_rate, double f0, unsigned post_shift = 1) {
+    std::array<BiquadQ31, Sections> cascade{};
+    for (std::size_t k = 0; k < Sections; k++) {
+        double q = 1 / (2 * detail::cos((2.0 * k + 1) * pi / (4.0 * Sections)));
+        cascade[k] = to_q31(rbj_lowpass(sample_rate, f0, q), post_shift);
+    }
+    return cascade;
+}
+
+template <std::size_t Sections>
+constexpr std::array<BiquadQ31, Sections> butterworth_highpass_q31(double sample_rate, double f0, unsigned post_shift = 1) {
+    std::array<BiquadQ31, Sections> cascade{};
+    for (std::size_t k = 0; k < Sections; k++) {
+        double q = 1 / (2 * detail::cos((2.0 * k + 1) * pi / (4.0 * Sections)));
+        cascade[k] = to_q31(rbj_highpass(sample_rate, f0, q), post_shift);
+    }
+    return cascade;
+}
+
+}  // namespace design
+}  // namespace adc
+
+#endif
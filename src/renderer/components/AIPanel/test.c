@@ -1,20 +1,777 @@
-//打印helloworld
+//命令行流处理程序：cc -O2 test.c -lm -lpthread，用法见adc_cli_main
+//clock_gettime和strtok_r是POSIX接口，-std=c11下要在第一个#include之前打开声明
+#define _POSIX_C_SOURCE 200809L
+//基准测试的perf_event_open要用syscall，它不属于POSIX，需要glibc的_DEFAULT_SOURCE
+#if defined(ADC_BENCHMARK) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE
+#endif
 #include <stdio.h>
-int main() {
-    printf("Hello, World!\n");
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//写一个热路径性能计数：定义ADC_PROFILE后，每个公开滤波入口统计调用次数、总/最小/最大周期和log2延迟直方图
+//周期来源：x86用rdtsc，Cortex-M用DWT周期计数器(先调adc_profile_init打开)，其余平台用clock_gettime纳秒
+//计数器是普通全局变量，多线程同时调用时统计会有竞争；未定义ADC_PROFILE时所有宏和接口都展开为空
+enum {
+    ADC_PROFILE_MEAN,
+    ADC_PROFILE_MEDIAN,
+    ADC_PROFILE_VARIANCE,
+    ADC_PROFILE_STANDARD_DEVIATION,
+    ADC_PROFILE_ADAPTIVE_THRESHOLD,
+    ADC_PROFILE_SATELLITE_PARSER,
+    ADC_PROFILE_CIC_DECIMATOR,
+    ADC_PROFILE_MEAN_INTERLEAVED,
+    ADC_PROFILE_VARIANCE_INTERLEAVED,
+    ADC_PROFILE_MEDIAN_INTERLEAVED,
+    ADC_PROFILE_MEAN_U16,
+    ADC_PROFILE_VARIANCE_U16,
+    ADC_PROFILE_MEDIAN_U16,
+    ADC_PROFILE_MEAN_PACKED12,
+    ADC_PROFILE_VARIANCE_PACKED12,
+    ADC_PROFILE_MEDIAN_PACKED12,
+    ADC_PROFILE_PREFIX_INDEX_BUILD,
+    ADC_PROFILE_BOX_FILTER_CASCADE,
+    ADC_PROFILE_COUNT
+};
+
+#ifdef ADC_PROFILE
+#define ADC_PROFILE_BUCKETS 32
+
+typedef struct {
+    uint64_t calls;
+    uint64_t total_cycles;
+    uint64_t min_cycles;
+    uint64_t max_cycles;
+    uint32_t histogram[ADC_PROFILE_BUCKETS];   //第b格统计 [2^b, 2^(b+1)) 个周期的调用
+} adc_profile_counter_t;
+
+static adc_profile_counter_t adc_profile_counters[ADC_PROFILE_COUNT];
+
+static const char *adc_profile_names[ADC_PROFILE_COUNT] = {
+    "adc_mean_filter", "adc_median_filter", "adc_variance_filter", "adc_standard_deviation_filter",
+    "adaptive_threshold_algorithm", "atgm336h_satellite_parser", "cic_decimator_process",
+    "adc_mean_filter_interleaved", "adc_variance_filter_interleaved", "adc_median_filter_interleaved",
+    "adc_mean_filter_u16", "adc_variance_filter_u16", "adc_median_filter_u16",
+    "adc_mean_filter_packed12", "adc_variance_filter_packed12", "adc_median_filter_packed12",
+    "adc_prefix_index_build", "adc_box_filter_cascade",
+};
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#define ADC_PROFILE_DEMCR (*(volatile uint32_t *)0xE000EDFCu)
+#define ADC_PROFILE_DWT_CTRL (*(volatile uint32_t *)0xE0001000u)
+#define ADC_PROFILE_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004u)
+#endif
+
+static inline uint64_t adc_profile_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(ADC_PROFILE_DWT_CYCCNT)
+    return ADC_PROFILE_DWT_CYCCNT;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static void adc_profile_record(int id, uint64_t start) {
+    adc_profile_counter_t *counter = &adc_profile_counters[id];
+    //DWT计数器只有32位，按32位回绕求差
+#if defined(ADC_PROFILE_DWT_CYCCNT)
+    uint64_t cycles = (uint32_t)(adc_profile_cycles() - start);
+#else
+    uint64_t cycles = adc_profile_cycles() - start;
+#endif
+    int bucket = 0;
+    while (bucket < ADC_PROFILE_BUCKETS - 1 && (cycles >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+    if (counter->calls == 0 || cycles < counter->min_cycles) {
+        counter->min_cycles = cycles;
+    }
+    if (cycles > counter->max_cycles) {
+        counter->max_cycles = cycles;
+    }
+    counter->calls++;
+    counter->total_cycles += cycles;
+    counter->histogram[bucket]++;
+}
+
+//Cortex-M上打开DWT周期计数器，其他平台无需调用
+void adc_profile_init(void) {
+#if defined(ADC_PROFILE_DWT_CYCCNT)
+    ADC_PROFILE_DEMCR |= 1u << 24;
+    ADC_PROFILE_DWT_CYCCNT = 0;
+    ADC_PROFILE_DWT_CTRL |= 1u;
+#endif
+}
+
+void adc_profile_reset(void) {
+    memset(adc_profile_counters, 0, sizeof(adc_profile_counters));
+}
+
+const adc_profile_counter_t *adc_profile_get(int id) {
+    return (id >= 0 && id < ADC_PROFILE_COUNT) ? &adc_profile_counters[id] : NULL;
+}
+
+//打印所有被调用过的入口的统计和非空的直方图格子
+void adc_profile_dump(FILE *out) {
+    fprintf(out, "%-32s %10s %14s %10s %10s %10s\n", "function", "calls", "total", "min", "avg", "max");
+    for (int id = 0; id < ADC_PROFILE_COUNT; id++) {
+        const adc_profile_counter_t *counter = &adc_profile_counters[id];
+        if (counter->calls == 0) {
+            continue;
+        }
+        fprintf(out, "%-32s %10llu %14llu %10llu %10llu %10llu\n", adc_profile_names[id],
+                (unsigned long long)counter->calls, (unsigned long long)counter->total_cycles,
+                (unsigned long long)counter->min_cycles, (unsigned long long)(counter->total_cycles / counter->calls),
+                (unsigned long long)counter->max_cycles);
+        for (int b = 0; b < ADC_PROFILE_BUCKETS; b++) {
+            if (counter->histogram[b] != 0) {
+                fprintf(out, "    >= 2^%-2d %10lu\n", b, (unsigned long)counter->histogram[b]);
+            }
+        }
+    }
+}
+
+#define ADC_PROFILE_BEGIN(id) uint64_t adc_profile_start_ = adc_profile_cycles()
+#define ADC_PROFILE_END(id) adc_profile_record((id), adc_profile_start_)
+#else
+#define ADC_PROFILE_BEGIN(id) ((void)0)
+#define ADC_PROFILE_END(id) ((void)0)
+#define adc_profile_init() ((void)0)
+#define adc_profile_reset() ((void)0)
+#define adc_profile_dump(out) ((void)(out))
+#endif
+
+//写一个SIMD运行时分派：均值、方差、自适应阈值共用的三个归约核(求和、平方和、大于阈值的和)
+//启动时按CPU能力选一次(x86用cpuid查SSE4.1/AVX2/AVX-512，AArch64用HWCAP查NEON)，之后入口函数都经这张表调用
+//环境变量ADC_SIMD_LEVEL=scalar|sse4.1|avx2|avx512|neon可强制指定级别(测试和基准用)，不能超过CPU实际支持的级别
+//平方和按uint64_t模2^64累加，方差用 sum((x-m)^2) = sumsq - 2*m*sum + n*m^2 在模2^64下展开，
+//只要最终结果在int64_t范围内(和逐项累加的标量版本要求相同)就是精确值
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#endif
+
+//二阶IIR节的系数：y = (b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2) >> shift，系数为Q(shift)定点数
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;
+} adc_biquad_coeffs_t;
+
+//对相邻4个通道跑一节DF-I二阶IIR，state为4个通道各自的[x1, x2, y1, y2]，input/output按stride交织
+typedef void (*adc_biquad_x4_fn)(const adc_biquad_coeffs_t *coeffs, int shift, int32_t *state,
+                                 const int32_t *input, int32_t *output, int frames, int stride);
+
+typedef struct {
+    const char *level;
+    int64_t (*sum)(const int *values, int length);
+    uint64_t (*sum_squares)(const int *values, int length);
+    int64_t (*sum_above)(const int *values, int length, int threshold);
+    adc_biquad_x4_fn biquad_x4;
+    int64_t (*dot_q15)(const int16_t *a, const int16_t *b, int length);
+    float (*dot_f32)(const float *a, const float *b, int length);
+    void (*unpack_be24)(const uint8_t *bytes, int *output, int words, int mask);
+} adc_kernels_t;
+
+static int64_t adc_sum_scalar(const int *values, int length) {
+    int64_t sum = 0;
+    for (int i = 0; i < length; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+static uint64_t adc_sum_squares_scalar(const int *values, int length) {
+    uint64_t sum = 0;
+    for (int i = 0; i < length; i++) {
+        sum += (uint64_t)((int64_t)values[i] * values[i]);
+    }
+    return sum;
+}
+
+static int64_t adc_sum_above_scalar(const int *values, int length, int threshold) {
+    int64_t sum = 0;
+    for (int i = 0; i < length; i++) {
+        if (values[i] > threshold) {
+            sum += values[i];
+        }
+    }
+    return sum;
+}
+
+//单通道DF-I，64位累加；和CMSIS的q31版本一样不做饱和，结果取累加值右移后的低32位(溢出回绕)，
+//SIMD版本按同样规则计算所以与标量逐位一致。输入需要留够余量：|x| < 2^28时不会溢出
+static void adc_biquad_df1_stage(const adc_biquad_coeffs_t *c, int shift, int32_t *state,
+                                 const int32_t *input, int32_t *output, int frames, int stride) {
+    int32_t x1 = state[0], x2 = state[1], y1 = state[2], y2 = state[3];
+    for (int f = 0; f < frames; f++) {
+        int32_t x = input[(size_t)f * stride];
+        uint64_t acc = (uint64_t)((int64_t)c->b0 * x) + (uint64_t)((int64_t)c->b1 * x1) + (uint64_t)((int64_t)c->b2 * x2)
+                     - (uint64_t)((int64_t)c->a1 * y1) - (uint64_t)((int64_t)c->a2 * y2);
+        int32_t y = (int32_t)(uint32_t)(acc >> shift);
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        output[(size_t)f * stride] = y;
+    }
+    state[0] = x1;
+    state[1] = x2;
+    state[2] = y1;
+    state[3] = y2;
+}
+
+static void adc_biquad_x4_scalar(const adc_biquad_coeffs_t *coeffs, int shift, int32_t *state,
+                                 const int32_t *input, int32_t *output, int frames, int stride) {
+    for (int ch = 0; ch < 4; ch++) {
+        adc_biquad_df1_stage(coeffs, shift, state + ch * 4, input + ch, output + ch, frames, stride);
+    }
+}
+
+//FIR内积：Q15乘积按64位累加，SIMD版本结果与标量完全一致；浮点版本累加顺序不同，只在舍入上有差别
+static int64_t adc_dot_q15_scalar(const int16_t *a, const int16_t *b, int length) {
+    int64_t total = 0;
+    for (int i = 0; i < length; i++) {
+        total += (int32_t)a[i] * b[i];
+    }
+    return total;
+}
+
+static float adc_dot_f32_scalar(const float *a, const float *b, int length) {
+    float total = 0;
+    for (int i = 0; i < length; i++) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+//3字节大端字(MAX30102的FIFO格式)转成int，再与mask按位与取有效位
+static void adc_unpack_be24_scalar(const uint8_t *bytes, int *output, int words, int mask) {
+    for (int i = 0; i < words; i++) {
+        const uint8_t *word = bytes + 3 * i;
+        output[i] = (((int)word[0] << 16) | ((int)word[1] << 8) | word[2]) & mask;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+//madd把相邻两个乘积加成int32，系数不含-32768时不会溢出(见adc_fir_q15_init)，再扩展到64位累加
+__attribute__((target("avx2")))
+static int64_t adc_dot_q15_avx2(const int16_t *a, const int16_t *b, int length) {
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256i pairs = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(a + i)), _mm256_loadu_si256((const __m256i *)(b + i)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(pairs)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(pairs, 1)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + adc_dot_q15_scalar(a + i, b + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static float adc_dot_f32_avx2(const float *a, const float *b, int length) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_add_ps(acc0, acc1));
+    float total = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    return total + adc_dot_f32_scalar(a + i, b + i, length - i);
+}
+
+//4个通道各占一个64位通道，_mm256_mul_epi32做32x32->64乘法；逻辑右移后低32位与标量的截断结果相同
+__attribute__((target("avx2")))
+static void adc_biquad_x4_avx2(const adc_biquad_coeffs_t *c, int shift, int32_t *state,
+                               const int32_t *input, int32_t *output, int frames, int stride) {
+    __m256i b0 = _mm256_set1_epi64x(c->b0);
+    __m256i b1 = _mm256_set1_epi64x(c->b1);
+    __m256i b2 = _mm256_set1_epi64x(c->b2);
+    __m256i a1 = _mm256_set1_epi64x(c->a1);
+    __m256i a2 = _mm256_set1_epi64x(c->a2);
+    __m128i count = _mm_cvtsi32_si128(shift);
+    __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    __m256i x1 = _mm256_cvtepi32_epi64(_mm_setr_epi32(state[0], state[4], state[8], state[12]));
+    __m256i x2 = _mm256_cvtepi32_epi64(_mm_setr_epi32(state[1], state[5], state[9], state[13]));
+    __m256i y1 = _mm256_cvtepi32_epi64(_mm_setr_epi32(state[2], state[6], state[10], state[14]));
+    __m256i y2 = _mm256_cvtepi32_epi64(_mm_setr_epi32(state[3], state[7], state[11], state[15]));
+    for (int f = 0; f < frames; f++) {
+        __m256i x = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)(input + (size_t)f * stride)));
+        __m256i acc = _mm256_add_epi64(_mm256_mul_epi32(b0, x), _mm256_mul_epi32(b1, x1));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(b2, x2));
+        acc = _mm256_sub_epi64(acc, _mm256_mul_epi32(a1, y1));
+        acc = _mm256_sub_epi64(acc, _mm256_mul_epi32(a2, y2));
+        __m256i y = _mm256_srl_epi64(acc, count);
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        _mm_storeu_si128((__m128i *)(output + (size_t)f * stride), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(y, pack)));
+    }
+    int32_t lanes[4][8];
+    _mm256_storeu_si256((__m256i *)lanes[0], x1);
+    _mm256_storeu_si256((__m256i *)lanes[1], x2);
+    _mm256_storeu_si256((__m256i *)lanes[2], y1);
+    _mm256_storeu_si256((__m256i *)lanes[3], y2);
+    for (int ch = 0; ch < 4; ch++) {
+        for (int k = 0; k < 4; k++) {
+            state[ch * 4 + k] = lanes[k][ch * 2];
+        }
+    }
+}
+
+//pshufb一次把4个3字节大端字排成4个小端int32；每次读16字节只用前12字节，末尾不足16字节的部分走标量
+__attribute__((target("sse4.1")))
+static void adc_unpack_be24_sse41(const uint8_t *bytes, int *output, int words, int mask) {
+    const __m128i order = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i keep = _mm_set1_epi32(mask);
+    int i = 0;
+    for (; 3 * i + 16 <= 3 * words; i += 4) {
+        __m128i raw = _mm_loadu_si128((const __m128i *)(bytes + 3 * i));
+        _mm_storeu_si128((__m128i *)(output + i), _mm_and_si128(_mm_shuffle_epi8(raw, order), keep));
+    }
+    adc_unpack_be24_scalar(bytes + 3 * i, output + i, words - i, mask);
+}
+
+__attribute__((target("sse4.1")))
+static int64_t adc_sum_sse41(const int *values, int length) {
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(v));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1] + adc_sum_scalar(values + i, length - i);
+}
+
+__attribute__((target("sse4.1")))
+static uint64_t adc_sum_squares_sse41(const int *values, int length) {
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        __m128i odd = _mm_srli_epi64(v, 32);
+        acc = _mm_add_epi64(acc, _mm_mul_epi32(v, v));
+        acc = _mm_add_epi64(acc, _mm_mul_epi32(odd, odd));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1] + adc_sum_squares_scalar(values + i, length - i);
+}
+
+__attribute__((target("sse4.1")))
+static int64_t adc_sum_above_sse41(const int *values, int length, int threshold) {
+    __m128i acc = _mm_setzero_si128();
+    __m128i limit = _mm_set1_epi32(threshold);
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        v = _mm_and_si128(v, _mm_cmpgt_epi32(v, limit));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(v));
+        acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    return lanes[0] + lanes[1] + adc_sum_above_scalar(values + i, length - i, threshold);
+}
+
+__attribute__((target("avx2")))
+static int64_t adc_sum_avx2(const int *values, int length) {
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + adc_sum_scalar(values + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t adc_sum_squares_avx2(const int *values, int length) {
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        __m256i odd = _mm256_srli_epi64(v, 32);
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(v, v));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(odd, odd));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + adc_sum_squares_scalar(values + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static int64_t adc_sum_above_avx2(const int *values, int length, int threshold) {
+    __m256i acc = _mm256_setzero_si256();
+    __m256i limit = _mm256_set1_epi32(threshold);
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        v = _mm256_and_si256(v, _mm256_cmpgt_epi32(v, limit));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + adc_sum_above_scalar(values + i, length - i, threshold);
+}
+
+__attribute__((target("avx512f")))
+static int64_t adc_sum_avx512(const int *values, int length) {
+    __m512i acc = _mm512_setzero_si512();
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void *)(values + i));
+        acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+    return _mm512_reduce_add_epi64(acc) + adc_sum_scalar(values + i, length - i);
+}
+
+__attribute__((target("avx512f")))
+static uint64_t adc_sum_squares_avx512(const int *values, int length) {
+    __m512i acc = _mm512_setzero_si512();
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void *)(values + i));
+        __m512i odd = _mm512_srli_epi64(v, 32);
+        acc = _mm512_add_epi64(acc, _mm512_mul_epi32(v, v));
+        acc = _mm512_add_epi64(acc, _mm512_mul_epi32(odd, odd));
+    }
+    uint64_t lanes[8];
+    _mm512_storeu_si512((void *)lanes, acc);
+    uint64_t sum = 0;
+    for (int lane = 0; lane < 8; lane++) {
+        sum += lanes[lane];
+    }
+    return sum + adc_sum_squares_scalar(values + i, length - i);
+}
+
+__attribute__((target("avx512f")))
+static int64_t adc_sum_above_avx512(const int *values, int length, int threshold) {
+    __m512i acc = _mm512_setzero_si512();
+    __m512i limit = _mm512_set1_epi32(threshold);
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m512i v = _mm512_loadu_si512((const void *)(values + i));
+        v = _mm512_maskz_mov_epi32(_mm512_cmpgt_epi32_mask(v, limit), v);
+        acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v)));
+        acc = _mm512_add_epi64(acc, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1)));
+    }
+    return _mm512_reduce_add_epi64(acc) + adc_sum_above_scalar(values + i, length - i, threshold);
+}
+#endif
+
+#if defined(__aarch64__)
+static int64_t adc_sum_neon(const int *values, int length) {
+    int64x2_t acc = vdupq_n_s64(0);
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        int32x4_t v = vld1q_s32(values + i);
+        acc = vaddw_s32(acc, vget_low_s32(v));
+        acc = vaddw_high_s32(acc, v);
+    }
+    return vaddvq_s64(acc) + adc_sum_scalar(values + i, length - i);
+}
+
+static uint64_t adc_sum_squares_neon(const int *values, int length) {
+    uint64x2_t acc = vdupq_n_u64(0);
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        int32x4_t v = vld1q_s32(values + i);
+        acc = vaddq_u64(acc, vreinterpretq_u64_s64(vmull_s32(vget_low_s32(v), vget_low_s32(v))));
+        acc = vaddq_u64(acc, vreinterpretq_u64_s64(vmull_high_s32(v, v)));
+    }
+    return vaddvq_u64(acc) + adc_sum_squares_scalar(values + i, length - i);
+}
+
+static int64_t adc_sum_above_neon(const int *values, int length, int threshold) {
+    int64x2_t acc = vdupq_n_s64(0);
+    int32x4_t limit = vdupq_n_s32(threshold);
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        int32x4_t v = vld1q_s32(values + i);
+        v = vandq_s32(v, vreinterpretq_s32_u32(vcgtq_s32(v, limit)));
+        acc = vaddw_s32(acc, vget_low_s32(v));
+        acc = vaddw_high_s32(acc, v);
+    }
+    return vaddvq_s64(acc) + adc_sum_above_scalar(values + i, length - i, threshold);
+}
+
+//vld4q把4个通道的[x1, x2, y1, y2]按分量拆成4个向量，乘加用vmlal/vmlsl的32x32->64形式
+static void adc_biquad_x4_neon(const adc_biquad_coeffs_t *c, int shift, int32_t *state,
+                               const int32_t *input, int32_t *output, int frames, int stride) {
+    int32x4x4_t s = vld4q_s32(state);
+    int32x4_t x1 = s.val[0], x2 = s.val[1], y1 = s.val[2], y2 = s.val[3];
+    int64x2_t count = vdupq_n_s64(-shift);
+    for (int f = 0; f < frames; f++) {
+        int32x4_t x = vld1q_s32(input + (size_t)f * stride);
+        int64x2_t low = vmull_n_s32(vget_low_s32(x), c->b0);
+        int64x2_t high = vmull_high_n_s32(x, c->b0);
+        low = vmlal_n_s32(low, vget_low_s32(x1), c->b1);
+        high = vmlal_high_n_s32(high, x1, c->b1);
+        low = vmlal_n_s32(low, vget_low_s32(x2), c->b2);
+        high = vmlal_high_n_s32(high, x2, c->b2);
+        low = vmlsl_n_s32(low, vget_low_s32(y1), c->a1);
+        high = vmlsl_high_n_s32(high, y1, c->a1);
+        low = vmlsl_n_s32(low, vget_low_s32(y2), c->a2);
+        high = vmlsl_high_n_s32(high, y2, c->a2);
+        uint32x2_t y_low = vmovn_u64(vshlq_u64(vreinterpretq_u64_s64(low), count));
+        uint32x2_t y_high = vmovn_u64(vshlq_u64(vreinterpretq_u64_s64(high), count));
+        int32x4_t y = vreinterpretq_s32_u32(vcombine_u32(y_low, y_high));
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        vst1q_s32(output + (size_t)f * stride, y);
+    }
+    s.val[0] = x1;
+    s.val[1] = x2;
+    s.val[2] = y1;
+    s.val[3] = y2;
+    vst4q_s32(state, s);
+}
+
+static int64_t adc_dot_q15_neon(const int16_t *a, const int16_t *b, int length) {
+    int64x2_t acc = vdupq_n_s64(0);
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        int16x8_t va = vld1q_s16(a + i);
+        int16x8_t vb = vld1q_s16(b + i);
+        acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(va), vget_low_s16(vb)));
+        acc = vpadalq_s32(acc, vmull_high_s16(va, vb));
+    }
+    return vaddvq_s64(acc) + adc_dot_q15_scalar(a + i, b + i, length - i);
+}
+
+static float adc_dot_f32_neon(const float *a, const float *b, int length) {
+    float32x4_t acc0 = vdupq_n_f32(0);
+    float32x4_t acc1 = vdupq_n_f32(0);
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1)) + adc_dot_f32_scalar(a + i, b + i, length - i);
+}
+
+//vld3q把16个字的高、中、低字节分到三个向量，再逐段扩展拼成int32
+static void adc_unpack_be24_neon(const uint8_t *bytes, int *output, int words, int mask) {
+    uint32x4_t keep = vdupq_n_u32((uint32_t)mask);
+    int i = 0;
+    for (; i + 16 <= words; i += 16) {
+        uint8x16x3_t raw = vld3q_u8(bytes + 3 * i);
+        uint16x8_t high[2] = {vmovl_u8(vget_low_u8(raw.val[0])), vmovl_high_u8(raw.val[0])};
+        uint16x8_t low[2] = {vorrq_u16(vshll_n_u8(vget_low_u8(raw.val[1]), 8), vmovl_u8(vget_low_u8(raw.val[2]))),
+                             vorrq_u16(vshll_high_n_u8(raw.val[1], 8), vmovl_high_u8(raw.val[2]))};
+        for (int half = 0; half < 2; half++) {
+            uint32x4_t first = vorrq_u32(vshll_n_u16(vget_low_u16(high[half]), 16), vmovl_u16(vget_low_u16(low[half])));
+            uint32x4_t second = vorrq_u32(vshll_high_n_u16(high[half], 16), vmovl_high_u16(low[half]));
+            vst1q_s32(output + i + half * 8, vreinterpretq_s32_u32(vandq_u32(first, keep)));
+            vst1q_s32(output + i + half * 8 + 4, vreinterpretq_s32_u32(vandq_u32(second, keep)));
+        }
+    }
+    adc_unpack_be24_scalar(bytes + 3 * i, output + i, words - i, mask);
+}
+#endif
+
+//按级别从低到高排列，adc_dispatch_supported里的下标与此对应
+static const adc_kernels_t adc_kernel_levels[] = {
+    {"scalar", adc_sum_scalar, adc_sum_squares_scalar, adc_sum_above_scalar, adc_biquad_x4_scalar,
+     adc_dot_q15_scalar, adc_dot_f32_scalar, adc_unpack_be24_scalar},
+#if defined(__x86_64__) || defined(__i386__)
+    {"sse4.1", adc_sum_sse41, adc_sum_squares_sse41, adc_sum_above_sse41, adc_biquad_x4_scalar,
+     adc_dot_q15_scalar, adc_dot_f32_scalar, adc_unpack_be24_sse41},
+    {"avx2", adc_sum_avx2, adc_sum_squares_avx2, adc_sum_above_avx2, adc_biquad_x4_avx2,
+     adc_dot_q15_avx2, adc_dot_f32_avx2, adc_unpack_be24_sse41},
+    {"avx512", adc_sum_avx512, adc_sum_squares_avx512, adc_sum_above_avx512, adc_biquad_x4_avx2,
+     adc_dot_q15_avx2, adc_dot_f32_avx2, adc_unpack_be24_sse41},
+#endif
+#if defined(__aarch64__)
+    {"neon", adc_sum_neon, adc_sum_squares_neon, adc_sum_above_neon, adc_biquad_x4_neon,
+     adc_dot_q15_neon, adc_dot_f32_neon, adc_unpack_be24_neon},
+#endif
+};
+
+#define ADC_KERNEL_LEVELS (int)(sizeof(adc_kernel_levels) / sizeof(adc_kernel_levels[0]))
+
+//静态初始化为标量版本，启动前或检测前调用也总是安全的
+static const adc_kernels_t *adc_kernels = &adc_kernel_levels[0];
+
+//当前CPU是否支持第level级
+static int adc_dispatch_supported(int level) {
+    if (level <= 0) {
+        return level == 0;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    switch (level) {
+    case 1: return __builtin_cpu_supports("sse4.1");
+    case 2: return __builtin_cpu_supports("avx2");
+    case 3: return __builtin_cpu_supports("avx512f");
+    default: return 0;
+    }
+#elif defined(__aarch64__) && defined(__linux__)
+    return level == 1 && (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#elif defined(__aarch64__)
+    return level == 1;
+#else
     return 0;
+#endif
+}
+
+//选择支持的最高级别，ADC_SIMD_LEVEL可以指定更低的级别；返回选中的级别名
+const char *adc_dispatch_init(void) {
+    int best = 0;
+    for (int level = 1; level < ADC_KERNEL_LEVELS; level++) {
+        if (adc_dispatch_supported(level)) {
+            best = level;
+        }
+    }
+    const char *forced = getenv("ADC_SIMD_LEVEL");
+    if (forced != NULL && forced[0] != '\0') {
+        int found = -1;
+        for (int level = 0; level < ADC_KERNEL_LEVELS; level++) {
+            if (strcmp(forced, adc_kernel_levels[level].level) == 0) {
+                found = level;
+            }
+        }
+        if (found < 0 || !adc_dispatch_supported(found)) {
+            fprintf(stderr, "ADC_SIMD_LEVEL=%s is not available here, using %s\n", forced, adc_kernel_levels[best].level);
+        } else {
+            best = found;
+        }
+    }
+    adc_kernels = &adc_kernel_levels[best];
+    return adc_kernels->level;
+}
+
+const char *adc_dispatch_level(void) {
+    return adc_kernels->level;
+}
+
+#if defined(__GNUC__)
+__attribute__((constructor))
+static void adc_dispatch_startup(void) {
+    adc_dispatch_init();
+}
+#endif
+
+//把CPU支持的每一级核与标量版本对照(不同长度、含负数和阈值两侧的数据)，返回不一致的次数
+int adc_dispatch_self_check(void) {
+    enum { LENGTH = 1031 };
+    static int values[LENGTH];
+    uint32_t seed = 2024u;
+    int mismatches = 0;
+    for (int i = 0; i < LENGTH; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        values[i] = (int)(seed >> 8) - (1 << 23);
+    }
+    for (int level = 1; level < ADC_KERNEL_LEVELS; level++) {
+        const adc_kernels_t *kernels = &adc_kernel_levels[level];
+        if (!adc_dispatch_supported(level)) {
+            continue;
+        }
+        for (int length = 0; length <= LENGTH; length += length < 40 ? 1 : 97) {
+            for (int offset = 0; offset < 3 && offset + length <= LENGTH; offset++) {
+                const int *p = values + offset;
+                int threshold = length > 0 ? p[length / 2] : 0;
+                mismatches += kernels->sum(p, length) != adc_sum_scalar(p, length);
+                mismatches += kernels->sum_squares(p, length) != adc_sum_squares_scalar(p, length);
+                mismatches += kernels->sum_above(p, length, threshold) != adc_sum_above_scalar(p, length, threshold);
+            }
+        }
+        //二阶IIR：4通道交织、行距5，输入留足余量
+        static const adc_biquad_coeffs_t coeffs = {1050152231, -2100304461, 1050152231, -2099786147, 1027080952};
+        int32_t input[200 * 5];
+        int32_t expected[200 * 5];
+        int32_t actual[200 * 5];
+        int32_t expected_state[16] = {0};
+        int32_t actual_state[16] = {0};
+        for (int i = 0; i < 200 * 5; i++) {
+            input[i] = values[i] >> 4;
+        }
+        adc_biquad_x4_scalar(&coeffs, 30, expected_state, input, expected, 200, 5);
+        kernels->biquad_x4(&coeffs, 30, actual_state, input, actual, 200, 5);
+        for (int f = 0; f < 200; f++) {
+            mismatches += memcmp(expected + f * 5, actual + f * 5, 4 * sizeof(int32_t)) != 0;
+        }
+        mismatches += memcmp(expected_state, actual_state, sizeof(expected_state)) != 0;
+        //Q15内积：要求逐位一致；用values的高低16位当两组样本，避开-32768
+        int16_t taps[LENGTH];
+        int16_t samples[LENGTH];
+        for (int i = 0; i < LENGTH; i++) {
+            taps[i] = (int16_t)(values[i] >> 9);
+            samples[i] = (int16_t)(values[LENGTH - 1 - i] >> 9);
+        }
+        for (int length = 0; length <= LENGTH; length += length < 40 ? 1 : 97) {
+            mismatches += kernels->dot_q15(taps, samples, length) != adc_dot_q15_scalar(taps, samples, length);
+        }
+        //3字节大端解包：把values当字节流，覆盖各种长度和起始偏移
+        int unpacked[LENGTH];
+        int reference[LENGTH];
+        for (int words = 0; words <= 300; words += words < 40 ? 1 : 37) {
+            for (int offset = 0; offset < 3; offset++) {
+                const uint8_t *bytes = (const uint8_t *)values + offset;
+                adc_unpack_be24_scalar(bytes, reference, words, 0x3FFFF);
+                kernels->unpack_be24(bytes, unpacked, words, 0x3FFFF);
+                mismatches += memcmp(reference, unpacked, (size_t)words * sizeof(int)) != 0;
+            }
+        }
+    }
+    return mismatches;
+}
+
+#ifdef ADC_BENCHMARK
+int adc_benchmark_main(int argc, char **argv);
+#else
+int adc_cli_main(int argc, char **argv);
+#endif
+int main(int argc, char **argv) {
+#ifdef ADC_BENCHMARK
+    return adc_benchmark_main(argc, argv);
+#else
+    return adc_cli_main(argc, argv);
+#endif
 }
+//以下几个滤波的C++模板版本(编译期窗口、静态状态)见adc_filters.hpp，取整规则相同
 //写一个adc均值滤波
 int adc_mean_filter(int *adc_values, int length) {
-    int sum = 0;
-    for (int i = 0; i < length; i++) {
-        sum += adc_values[i];
-    }
-    return sum / length;
+    ADC_PROFILE_BEGIN(ADC_PROFILE_MEAN);
+    int64_t sum = adc_kernels->sum(adc_values, length);
+    ADC_PROFILE_END(ADC_PROFILE_MEAN);
+    return (int)(sum / length);
 }
 //写一个adc中值滤波
 int adc_median_filter(int *adc_values, int length) {
-    int median = 0;
+    ADC_PROFILE_BEGIN(ADC_PROFILE_MEDIAN);
     for (int i = 0; i < length; i++) {
         for (int j = i + 1; j < length; j++) {
             if (adc_values[i] > adc_values[j]) {
@@ -24,40 +781,3525 @@ int adc_median_filter(int *adc_values, int length) {
             }
         }
     }
+    ADC_PROFILE_END(ADC_PROFILE_MEDIAN);
     return adc_values[length / 2];
 }
 //写一个adc方差滤波
 int adc_variance_filter(int *adc_values, int length) {
-    int variance = 0;   
-    int mean = adc_mean_filter(adc_values, length);
-    for (int i = 0; i < length; i++) {
-        variance += (adc_values[i] - mean) * (adc_values[i] - mean);
-    }
-    return variance / length;
+    ADC_PROFILE_BEGIN(ADC_PROFILE_VARIANCE);
+    int64_t sum = adc_kernels->sum(adc_values, length);
+    int64_t mean = sum / length;
+    uint64_t sum_squares = adc_kernels->sum_squares(adc_values, length);
+    int64_t variance = (int64_t)(sum_squares - 2 * (uint64_t)mean * (uint64_t)sum + (uint64_t)length * (uint64_t)mean * (uint64_t)mean);
+    ADC_PROFILE_END(ADC_PROFILE_VARIANCE);
+    return (int)(variance / length);
 }
 //写一个adc标准差滤波
 int adc_standard_deviation_filter(int *adc_values, int length) {
+    ADC_PROFILE_BEGIN(ADC_PROFILE_STANDARD_DEVIATION);
     int standard_deviation = 0;
     int variance = adc_variance_filter(adc_values, length);
-    return sqrt(variance);
+    standard_deviation = (int)sqrt(variance);
+    ADC_PROFILE_END(ADC_PROFILE_STANDARD_DEVIATION);
+    return standard_deviation;
 }
 //心率传感器max30102写一个自适应阈值算法
 int adaptive_threshold_algorithm(int *adc_values, int length) {
-    int threshold = 0;
+    ADC_PROFILE_BEGIN(ADC_PROFILE_ADAPTIVE_THRESHOLD);
     int mean = adc_mean_filter(adc_values, length);
+    int64_t threshold = adc_kernels->sum_above(adc_values, length, mean);
+    ADC_PROFILE_END(ADC_PROFILE_ADAPTIVE_THRESHOLD);
+    return (int)(threshold / length);
+}
+
+//atgm336h卫星解析函数
+int atgm336h_satellite_parser(int *satellite_data, int length) {
+    ADC_PROFILE_BEGIN(ADC_PROFILE_SATELLITE_PARSER);
+    int64_t sum = 0;
+    for (int i = 0; i < length; i++) {
+        sum += satellite_data[i];
+    }
+    ADC_PROFILE_END(ADC_PROFILE_SATELLITE_PARSER);
+    return (int)(sum / length);
+}
+
+//写一个除法器：同一个除数反复使用时，预先算好倒数，把整数除法换成一次乘法加移位(libdivide的做法)
+//除数为2的幂时只用移位；被除数绝对值超过32位时退回普通除法，结果始终与C的'/'一致(向零截断)
+typedef struct {
+    uint32_t divisor;
+    uint32_t multiplier;    //m = floor(2^32 * (2^l - d) / d) + 1，l = ceil(log2(d))
+    uint8_t shift1;
+    uint8_t shift2;
+    int8_t power_of_two;    //d为2的幂时为log2(d)，否则为-1
+} adc_divider_t;
+
+//divisor必须大于0
+void adc_divider_init(adc_divider_t *divider, uint32_t divisor) {
+    int l = 0;
+    while (l < 32 && ((uint64_t)1 << l) < divisor) {
+        l++;
+    }
+    divider->divisor = divisor;
+    divider->power_of_two = ((uint64_t)1 << l) == divisor ? (int8_t)l : -1;
+    divider->multiplier = (uint32_t)((((uint64_t)1 << 32) * ((((uint64_t)1 << l) - divisor)) / divisor) + 1);
+    divider->shift1 = l > 0 ? 1 : 0;
+    divider->shift2 = l > 0 ? (uint8_t)(l - 1) : 0;
+}
+
+static inline uint32_t adc_divider_u32(const adc_divider_t *divider, uint32_t n) {
+    if (divider->power_of_two >= 0) {
+        return n >> divider->power_of_two;
+    }
+    uint32_t t = (uint32_t)(((uint64_t)divider->multiplier * n) >> 32);
+    return (t + ((n - t) >> divider->shift1)) >> divider->shift2;
+}
+
+//有符号版本，按绝对值相除再恢复符号，所以和'/'一样向零截断
+static inline int64_t adc_divider_s64(const adc_divider_t *divider, int64_t n) {
+    uint64_t magnitude = n < 0 ? (uint64_t)0 - (uint64_t)n : (uint64_t)n;
+    uint64_t quotient;
+    if (magnitude <= UINT32_MAX) {
+        quotient = adc_divider_u32(divider, (uint32_t)magnitude);
+    } else {
+        quotient = magnitude / divider->divisor;
+    }
+    return n < 0 ? -(int64_t)quotient : (int64_t)quotient;
+}
+
+//写一个免除法的均值/方差/自适应阈值：长度固定反复调用时，先用adc_divider_init(&divider, length)算好倒数
+//divider的除数必须等于length，结果与adc_mean_filter、adc_variance_filter、adaptive_threshold_algorithm一致
+int adc_mean_filter_div(const int *adc_values, int length, const adc_divider_t *divider) {
+    int64_t sum = adc_kernels->sum(adc_values, length);
+    return (int)adc_divider_s64(divider, sum);
+}
+
+int adc_variance_filter_div(const int *adc_values, int length, const adc_divider_t *divider) {
+    int64_t sum = adc_kernels->sum(adc_values, length);
+    int64_t mean = adc_divider_s64(divider, sum);
+    uint64_t sum_squares = adc_kernels->sum_squares(adc_values, length);
+    int64_t variance = (int64_t)(sum_squares - 2 * (uint64_t)mean * (uint64_t)sum + (uint64_t)length * (uint64_t)mean * (uint64_t)mean);
+    return (int)adc_divider_s64(divider, variance);
+}
+
+int adaptive_threshold_algorithm_div(const int *adc_values, int length, const adc_divider_t *divider) {
+    int mean = adc_mean_filter_div(adc_values, length, divider);
+    int64_t threshold = adc_kernels->sum_above(adc_values, length, mean);
+    return (int)adc_divider_s64(divider, threshold);
+}
+
+//写一个CIC抽取滤波器(N级级联积分梳状)，用于16~64倍过采样的ADC，按整块DMA数据处理
+//积分器和梳状器都用uint32_t模2^32运算，中间溢出回绕不影响结果，
+//只要 input_bits + stages*log2(decimation) <= 32 输出就是精确的
+//总位数不超过31时按有符号数归一化，正负输入都可以；恰好32位时输入必须是非负的ADC码，按uint32_t归一化
+#define CIC_MAX_STAGES 6
+
+typedef struct {
+    int stages;             //级数N
+    int decimation;         //抽取倍数R，差分延迟M固定为1
+    int phase;              //当前抽取相位，跨块保持
+    int shift;              //R为2的幂时用右移做增益归一化，否则为-1
+    int unsigned_output;    //位增长后恰好32位，梳状器输出按无符号数归一化
+    adc_divider_t gain;     //R^N的倒数，R不是2的幂时用乘法代替除法归一化
+    uint32_t integrator[CIC_MAX_STAGES];
+    uint32_t comb[CIC_MAX_STAGES];
+} cic_decimator_t;
+
+//初始化CIC，input_bits为ADC有效位数(有符号数含符号位)，位增长超过32位时返回-1
+//input_bits + 位增长 == 32 时只接受非负输入(单极性ADC)，有符号输入需要 <= 31
+int cic_decimator_init(cic_decimator_t *cic, int stages, int decimation, int input_bits) {
+    int growth_bits = 0;
+    uint64_t gain = 1;
+    if (cic == NULL || stages < 1 || stages > CIC_MAX_STAGES || decimation < 2 || input_bits < 1) {
+        return -1;
+    }
+    //R^N超过2^32时位增长必然超过32位，先返回，避免乘法回绕和后面移位越界
+    for (int i = 0; i < stages; i++) {
+        if (gain > ((uint64_t)1 << 32) / (uint64_t)decimation) {
+            return -1;
+        }
+        gain *= (uint64_t)decimation;
+    }
+    while (((uint64_t)1 << growth_bits) < gain) {
+        growth_bits++;
+    }
+    if (input_bits + growth_bits > 32) {
+        return -1;
+    }
+    memset(cic, 0, sizeof(*cic));
+    cic->stages = stages;
+    cic->decimation = decimation;
+    adc_divider_init(&cic->gain, (uint32_t)gain);
+    cic->shift = (((uint64_t)1 << growth_bits) == gain) ? growth_bits : -1;
+    cic->unsigned_output = input_bits + growth_bits == 32;
+    return 0;
+}
+
+//清空CIC状态，重新开始一段数据流
+void cic_decimator_reset(cic_decimator_t *cic) {
+    memset(cic->integrator, 0, sizeof(cic->integrator));
+    memset(cic->comb, 0, sizeof(cic->comb));
+    cic->phase = 0;
+}
+
+//处理一整块ADC数据，每R个输入产生一个输出，返回写入output的个数
+//output至少要有 length / decimation + 1 个元素
+int cic_decimator_process(cic_decimator_t *cic, const int *adc_values, int length, int *output) {
+    ADC_PROFILE_BEGIN(ADC_PROFILE_CIC_DECIMATOR);
+    int stages = cic->stages;
+    int count = 0;
+    int phase = cic->phase;
+    uint32_t integrator[CIC_MAX_STAGES];
+    memcpy(integrator, cic->integrator, sizeof(integrator));
     for (int i = 0; i < length; i++) {
-        if (adc_values[i] > mean) {
-            threshold += adc_values[i];
+        uint32_t acc = (uint32_t)adc_values[i];
+        for (int s = 0; s < stages; s++) {
+            integrator[s] += acc;
+            acc = integrator[s];
+        }
+        if (++phase == cic->decimation) {
+            phase = 0;
+            for (int s = 0; s < stages; s++) {
+                uint32_t delayed = cic->comb[s];
+                cic->comb[s] = acc;
+                acc -= delayed;
+            }
+            if (cic->unsigned_output) {
+                output[count++] = (int)(cic->shift >= 0 ? acc >> cic->shift : adc_divider_u32(&cic->gain, acc));
+            } else if (cic->shift >= 0) {
+                output[count++] = (int)((int32_t)acc >> cic->shift);
+            } else {
+                output[count++] = (int)adc_divider_s64(&cic->gain, (int32_t)acc);
+            }
         }
     }
-    return threshold / length;
+    memcpy(cic->integrator, integrator, sizeof(integrator));
+    cic->phase = phase;
+    ADC_PROFILE_END(ADC_PROFILE_CIC_DECIMATOR);
+    return count;
 }
 
-//atgm336h卫星解析函数
-int atgm336h_satellite_parser(int *satellite_data, int length) {
-    int satellite_data = 0;
+//写一个多通道交织ADC处理：DMA数据排列为 ch0,ch1,...,chN-1,ch0,...
+//frames为每个通道的采样数，channels为通道数，stride为相邻两帧首元素的间距(>=channels)
+//一次扫描同时累加所有通道，内层按通道连续访问便于编译器向量化，不需要先解交织
+#define ADC_MAX_CHANNELS 16
+
+//快速选择第k小的元素(原地部分排序)，结果与完全排序后取values[k]一致
+//int和uint16_t两个版本由同一份宏展开，分区逻辑只写一遍
+#define ADC_DEFINE_SELECT_KTH(name, type) \
+static type name(type *values, int length, int k) { \
+    int left = 0; \
+    int right = length - 1; \
+    while (left < right) { \
+        type pivot = values[left + (right - left) / 2]; \
+        int i = left; \
+        int j = right; \
+        while (i <= j) { \
+            while (values[i] < pivot) i++; \
+            while (values[j] > pivot) j--; \
+            if (i <= j) { \
+                type temp = values[i]; \
+                values[i] = values[j]; \
+                values[j] = temp; \
+                i++; \
+                j--; \
+            } \
+        } \
+        if (k <= j) { \
+            right = j; \
+        } else if (k >= i) { \
+            left = i; \
+        } else { \
+            break; \
+        } \
+    } \
+    return values[k]; \
+}
+
+ADC_DEFINE_SELECT_KTH(adc_select_kth, int)
+ADC_DEFINE_SELECT_KTH(adc_select_kth_u16, uint16_t)
+
+static int adc_interleaved_args_valid(int frames, int channels, int stride) {
+    return frames > 0 && channels > 0 && channels <= ADC_MAX_CHANNELS && stride >= channels;
+}
+
+//多通道均值，means[ch]为每个通道的结果，参数非法返回-1
+int adc_mean_filter_interleaved(const int *adc_values, int frames, int channels, int stride, int *means) {
+    int64_t sums[ADC_MAX_CHANNELS] = {0};
+    if (!adc_interleaved_args_valid(frames, channels, stride)) {
+        return -1;
+    }
+    ADC_PROFILE_BEGIN(ADC_PROFILE_MEAN_INTERLEAVED);
+    for (int f = 0; f < frames; f++) {
+        const int *frame = adc_values + (size_t)f * stride;
+        for (int ch = 0; ch < channels; ch++) {
+            sums[ch] += frame[ch];
+        }
+    }
+    for (int ch = 0; ch < channels; ch++) {
+        means[ch] = (int)(sums[ch] / frames);
+    }
+    ADC_PROFILE_END(ADC_PROFILE_MEAN_INTERLEAVED);
+    return 0;
+}
+
+//多通道方差，一次扫描同时累加和与平方和
+//用 sum((x-m)^2) = sumsq - 2*m*sum + n*m^2 展开，m取截断后的整数均值，与adc_variance_filter结果一致
+int adc_variance_filter_interleaved(const int *adc_values, int frames, int channels, int stride, int *variances) {
+    int64_t sums[ADC_MAX_CHANNELS] = {0};
+    int64_t sum_squares[ADC_MAX_CHANNELS] = {0};
+    if (!adc_interleaved_args_valid(frames, channels, stride)) {
+        return -1;
+    }
+    ADC_PROFILE_BEGIN(ADC_PROFILE_VARIANCE_INTERLEAVED);
+    for (int f = 0; f < frames; f++) {
+        const int *frame = adc_values + (size_t)f * stride;
+        for (int ch = 0; ch < channels; ch++) {
+            int64_t value = frame[ch];
+            sums[ch] += value;
+            sum_squares[ch] += value * value;
+        }
+    }
+    for (int ch = 0; ch < channels; ch++) {
+        int64_t mean = sums[ch] / frames;
+        int64_t deviation = sum_squares[ch] - 2 * mean * sums[ch] + (int64_t)frames * mean * mean;
+        variances[ch] = (int)(deviation / frames);
+    }
+    ADC_PROFILE_END(ADC_PROFILE_VARIANCE_INTERLEAVED);
+    return 0;
+}
+
+//多通道中值，scratch为调用者提供的frames个int的临时空间，逐通道收集后快速选择，原始数据不被修改
+int adc_median_filter_interleaved(const int *adc_values, int frames, int channels, int stride, int *scratch, int *medians) {
+    if (!adc_interleaved_args_valid(frames, channels, stride) || scratch == NULL) {
+        return -1;
+    }
+    ADC_PROFILE_BEGIN(ADC_PROFILE_MEDIAN_INTERLEAVED);
+    for (int ch = 0; ch < channels; ch++) {
+        for (int f = 0; f < frames; f++) {
+            scratch[f] = adc_values[(size_t)f * stride + ch];
+        }
+        medians[ch] = adc_select_kth(scratch, frames, frames / 2);
+    }
+    ADC_PROFILE_END(ADC_PROFILE_MEDIAN_INTERLEAVED);
+    return 0;
+}
+
+
+//写一个uint16_t输入的ADC滤波，12位采样直接存成uint16_t，不必再扩成int拷贝一份
+//结果的取整方式与int版本一致(均值截断，方差以截断后的均值为中心)
+int adc_mean_filter_u16(const uint16_t *adc_values, int length) {
+    ADC_PROFILE_BEGIN(ADC_PROFILE_MEAN_U16);
+    uint64_t sum = 0;
+    for (int i = 0; i < length; i++) {
+        sum += adc_values[i];
+    }
+    ADC_PROFILE_END(ADC_PROFILE_MEAN_U16);
+    return (int)(sum / (uint64_t)length);
+}
+
+int adc_variance_filter_u16(const uint16_t *adc_values, int length) {
+    ADC_PROFILE_BEGIN(ADC_PROFILE_VARIANCE_U16);
+    int64_t sum = 0;
+    int64_t sum_squares = 0;
+    for (int i = 0; i < length; i++) {
+        int64_t value = adc_values[i];
+        sum += value;
+        sum_squares += value * value;
+    }
+    int64_t mean = sum / length;
+    int64_t variance = (int64_t)((uint64_t)sum_squares - 2 * (uint64_t)mean * (uint64_t)sum + (uint64_t)length * (uint64_t)mean * (uint64_t)mean);
+    ADC_PROFILE_END(ADC_PROFILE_VARIANCE_U16);
+    return (int)(variance / length);
+}
+
+int adc_standard_deviation_filter_u16(const uint16_t *adc_values, int length) {
+    return (int)sqrt(adc_variance_filter_u16(adc_values, length));
+}
+
+//uint16_t中值，和adc_median_filter一样会原地重排adc_values
+int adc_median_filter_u16(uint16_t *adc_values, int length) {
+    ADC_PROFILE_BEGIN(ADC_PROFILE_MEDIAN_U16);
+    int median = adc_select_kth_u16(adc_values, length, length / 2);
+    ADC_PROFILE_END(ADC_PROFILE_MEDIAN_U16);
+    return median;
+}
+
+//写一个12位紧凑打包的ADC滤波，每2个采样占3个字节：
+//byte0 = s0[7:0]，byte1 = s0[11:8] | s1[3:0] << 4，byte2 = s1[11:4]
+static inline uint16_t adc_packed12_at(const uint8_t *packed, int index) {
+    const uint8_t *p = packed + (size_t)(index >> 1) * 3;
+    if (index & 1) {
+        return (uint16_t)((p[1] >> 4) | (p[2] << 4));
+    }
+    return (uint16_t)(p[0] | ((p[1] & 0x0F) << 8));
+}
+
+//把length个12位打包采样解到uint16_t数组
+void adc_unpack12(const uint8_t *packed, int length, uint16_t *output) {
+    int i = 0;
+    for (; i + 1 < length; i += 2) {
+        const uint8_t *p = packed + (size_t)(i >> 1) * 3;
+        output[i] = (uint16_t)(p[0] | ((p[1] & 0x0F) << 8));
+        output[i + 1] = (uint16_t)((p[1] >> 4) | (p[2] << 4));
+    }
+    if (i < length) {
+        output[i] = adc_packed12_at(packed, i);
+    }
+}
+
+int adc_mean_filter_packed12(const uint8_t *packed, int length) {
+    ADC_PROFILE_BEGIN(ADC_PROFILE_MEAN_PACKED12);
+    uint64_t sum = 0;
+    for (int i = 0; i < length; i++) {
+        sum += adc_packed12_at(packed, i);
+    }
+    ADC_PROFILE_END(ADC_PROFILE_MEAN_PACKED12);
+    return (int)(sum / (uint64_t)length);
+}
+
+int adc_variance_filter_packed12(const uint8_t *packed, int length) {
+    ADC_PROFILE_BEGIN(ADC_PROFILE_VARIANCE_PACKED12);
+    int64_t sum = 0;
+    int64_t sum_squares = 0;
     for (int i = 0; i < length; i++) {
-        satellite_data += satellite_data[i];
+        int64_t value = adc_packed12_at(packed, i);
+        sum += value;
+        sum_squares += value * value;
     }
-    return satellite_data / length;
-}
\ No newline at end of file
+    int64_t mean = sum / length;
+    ADC_PROFILE_END(ADC_PROFILE_VARIANCE_PACKED12);
+    return (int)((sum_squares - 2 * mean * sum + (int64_t)length * mean * mean) / length);
+}
+
+int adc_standard_deviation_filter_packed12(const uint8_t *packed, int length) {
+    return (int)sqrt(adc_variance_filter_packed12(packed, length));
+}
+
+//打包数据的中值需要length个uint16_t的临时空间，packed本身不被修改
+int adc_median_filter_packed12(const uint8_t *packed, int length, uint16_t *scratch) {
+    ADC_PROFILE_BEGIN(ADC_PROFILE_MEDIAN_PACKED12);
+    adc_unpack12(packed, length, scratch);
+    int median = adc_median_filter_u16(scratch, length);
+    ADC_PROFILE_END(ADC_PROFILE_MEDIAN_PACKED12);
+    return median;
+}
+
+
+//写一个前缀和索引，对同一段采集数据一次建好后，任意区间的均值/方差/标准差都是O(1)查询
+//sums和sum_squares由调用者提供，各length+1个int64_t，下标i存前i个采样的累加
+//平方和用64位累加，|x| < 2^20时每项小于2^40，最多容纳2^63/2^40 = 2^23(约8M)个采样
+#define ADC_PREFIX_MAX_LENGTH (1 << 23)
+
+typedef struct {
+    int length;
+    int64_t *sums;
+    int64_t *sum_squares;
+} adc_prefix_index_t;
+
+//一次扫描建立索引，length超过ADC_PREFIX_MAX_LENGTH时平方和可能溢出，返回-1
+int adc_prefix_index_build(adc_prefix_index_t *index, const int *adc_values, int length, int64_t *sums, int64_t *sum_squares) {
+    if (length < 0 || length > ADC_PREFIX_MAX_LENGTH) {
+        return -1;
+    }
+    int64_t sum = 0;
+    ADC_PROFILE_BEGIN(ADC_PROFILE_PREFIX_INDEX_BUILD);
+    int64_t sum_square = 0;
+    index->length = length;
+    index->sums = sums;
+    index->sum_squares = sum_squares;
+    sums[0] = 0;
+    sum_squares[0] = 0;
+    for (int i = 0; i < length; i++) {
+        int64_t value = adc_values[i];
+        sum += value;
+        sum_square += value * value;
+        sums[i + 1] = sum;
+        sum_squares[i + 1] = sum_square;
+    }
+    ADC_PROFILE_END(ADC_PROFILE_PREFIX_INDEX_BUILD);
+    return 0;
+}
+
+//区间[start, end)的均值，与对该区间调用adc_mean_filter结果一致，区间非法返回0
+int adc_prefix_range_mean(const adc_prefix_index_t *index, int start, int end) {
+    if (start < 0 || end > index->length || start >= end) {
+        return 0;
+    }
+    return (int)((index->sums[end] - index->sums[start]) / (end - start));
+}
+
+//区间[start, end)的方差，以截断后的整数均值为中心，与adc_variance_filter结果一致
+int adc_prefix_range_variance(const adc_prefix_index_t *index, int start, int end) {
+    if (start < 0 || end > index->length || start >= end) {
+        return 0;
+    }
+    int64_t count = end - start;
+    int64_t sum = index->sums[end] - index->sums[start];
+    int64_t sum_squares = index->sum_squares[end] - index->sum_squares[start];
+    int64_t mean = sum / count;
+    int64_t variance = (int64_t)((uint64_t)sum_squares - 2 * (uint64_t)mean * (uint64_t)sum + (uint64_t)count * (uint64_t)mean * (uint64_t)mean);
+    return (int)(variance / count);
+}
+
+int adc_prefix_range_standard_deviation(const adc_prefix_index_t *index, int start, int end) {
+    return (int)sqrt(adc_prefix_range_variance(index, start, end));
+}
+
+
+//写一个级联盒式滤波(多次滑动平均)，3次左右即可近似高斯平滑
+//每一遍用滑动和实现，复杂度O(n)与窗口宽度无关；窗口居中，两端用首尾采样补齐
+//output可以等于adc_values(原地处理)，每遍只需一个宽度为w的环形缓存保存被覆盖的原值
+#define ADC_BOX_MAX_WIDTH 512
+
+static void adc_box_filter_pass(int *values, int length, int width, int *ring) {
+    adc_divider_t divider;
+    adc_divider_init(&divider, (uint32_t)width);
+    int half_left = (width - 1) / 2;
+    int half_right = width - 1 - half_left;
+    int first = values[0];
+    int last = values[length - 1];
+    int64_t sum = 0;
+    for (int j = -half_left; j <= half_right; j++) {
+        sum += values[j < 0 ? 0 : (j >= length ? length - 1 : j)];
+    }
+    for (int i = 0; i < length; i++) {
+        int leaving = i - half_left;
+        int entering = i + 1 + half_right;
+        ring[i % width] = values[i];
+        values[i] = (int)adc_divider_s64(&divider, sum);
+        sum -= leaving < 0 ? first : ring[leaving % width];
+        sum += entering >= length - 1 ? last : values[entering];
+    }
+}
+
+//对adc_values做passes遍盒式滤波，第p遍宽度为widths[p]，宽度需在1~ADC_BOX_MAX_WIDTH之间
+int adc_box_filter_cascade(const int *adc_values, int length, const int *widths, int passes, int *output) {
+    int ring[ADC_BOX_MAX_WIDTH];
+    if (length < 1 || passes < 1) {
+        return -1;
+    }
+    for (int p = 0; p < passes; p++) {
+        if (widths[p] < 1 || widths[p] > ADC_BOX_MAX_WIDTH) {
+            return -1;
+        }
+    }
+    ADC_PROFILE_BEGIN(ADC_PROFILE_BOX_FILTER_CASCADE);
+    if (output != adc_values) {
+        memcpy(output, adc_values, (size_t)length * sizeof(int));
+    }
+    for (int p = 0; p < passes; p++) {
+        if (widths[p] > 1) {
+            adc_box_filter_pass(output, length, widths[p], ring);
+        }
+    }
+    ADC_PROFILE_END(ADC_PROFILE_BOX_FILTER_CASCADE);
+    return 0;
+}
+
+//按目标高斯标准差sigma计算passes遍盒式滤波的宽度(奇数宽度wl和wl+2混合，使总方差最接近sigma^2)
+void adc_box_widths_for_gaussian(double sigma, int passes, int *widths) {
+    double ideal = sqrt(12.0 * sigma * sigma / passes + 1.0);
+    int lower = (int)floor(ideal);
+    if (lower % 2 == 0) {
+        lower--;
+    }
+    if (lower < 1) {
+        lower = 1;
+    }
+    int upper = lower + 2;
+    double m = (12.0 * sigma * sigma - passes * lower * lower - 4.0 * passes * lower - 3.0 * passes) / (-4.0 * lower - 4.0);
+    int lower_count = (int)floor(m + 0.5);
+    for (int p = 0; p < passes; p++) {
+        widths[p] = p < lower_count ? lower : upper;
+    }
+}
+
+
+//写一个批量接口：一次调用处理成千上万条独立的短记录，省掉逐条调用的开销
+//记录可以用(指针, 长度)描述符数组给出，也可以是固定行距的二维块(第r条从block + r * stride开始)
+//每条记录内部走SIMD分派的归约核；相邻记录长度相同时共用一个预先算好的倒数，整批都不做除法
+//行主序的块如果要让SIMD通道跨记录并行需要gather，对短记录反而更慢，所以向量化放在记录内部
+typedef struct {
+    const int *values;
+    int length;
+} adc_record_t;
+
+static inline int adc_batch_variance(const int *values, int length, const adc_divider_t *divider) {
+    int64_t sum = adc_kernels->sum(values, length);
+    int64_t mean = adc_divider_s64(divider, sum);
+    uint64_t sum_squares = adc_kernels->sum_squares(values, length);
+    int64_t variance = (int64_t)(sum_squares - 2 * (uint64_t)mean * (uint64_t)sum + (uint64_t)length * (uint64_t)mean * (uint64_t)mean);
+    return (int)adc_divider_s64(divider, variance);
+}
+
+static int adc_records_valid(const adc_record_t *records, int count) {
+    for (int r = 0; r < count; r++) {
+        if (records[r].length < 1 || records[r].values == NULL) {
+            return 0;
+        }
+    }
+    return count >= 0;
+}
+
+//results[r]为第r条记录的均值，有记录长度小于1时返回-1且不写results
+int adc_mean_filter_batch(const adc_record_t *records, int count, int *results) {
+    adc_divider_t divider;
+    int divider_length = 0;
+    if (!adc_records_valid(records, count)) {
+        return -1;
+    }
+    for (int r = 0; r < count; r++) {
+        if (records[r].length != divider_length) {
+            divider_length = records[r].length;
+            adc_divider_init(&divider, (uint32_t)divider_length);
+        }
+        results[r] = (int)adc_divider_s64(&divider, adc_kernels->sum(records[r].values, records[r].length));
+    }
+    return 0;
+}
+
+int adc_variance_filter_batch(const adc_record_t *records, int count, int *results) {
+    adc_divider_t divider;
+    int divider_length = 0;
+    if (!adc_records_valid(records, count)) {
+        return -1;
+    }
+    for (int r = 0; r < count; r++) {
+        if (records[r].length != divider_length) {
+            divider_length = records[r].length;
+            adc_divider_init(&divider, (uint32_t)divider_length);
+        }
+        results[r] = adc_batch_variance(records[r].values, records[r].length, &divider);
+    }
+    return 0;
+}
+
+//中值需要scratch，长度不小于最长的记录，记录本身不被修改
+int adc_median_filter_batch(const adc_record_t *records, int count, int *scratch, int *results) {
+    if (!adc_records_valid(records, count) || scratch == NULL) {
+        return -1;
+    }
+    for (int r = 0; r < count; r++) {
+        memcpy(scratch, records[r].values, (size_t)records[r].length * sizeof(int));
+        results[r] = adc_select_kth(scratch, records[r].length, records[r].length / 2);
+    }
+    return 0;
+}
+
+static int adc_block_args_valid(const int *block, int records, int length, int stride) {
+    return block != NULL && records >= 0 && length >= 1 && stride >= length;
+}
+
+//二维块：records条记录，每条length个采样，行距stride个int
+int adc_mean_filter_block(const int *block, int records, int length, int stride, int *results) {
+    adc_divider_t divider;
+    if (!adc_block_args_valid(block, records, length, stride)) {
+        return -1;
+    }
+    adc_divider_init(&divider, (uint32_t)length);
+    for (int r = 0; r < records; r++) {
+        results[r] = (int)adc_divider_s64(&divider, adc_kernels->sum(block + (size_t)r * stride, length));
+    }
+    return 0;
+}
+
+int adc_variance_filter_block(const int *block, int records, int length, int stride, int *results) {
+    adc_divider_t divider;
+    if (!adc_block_args_valid(block, records, length, stride)) {
+        return -1;
+    }
+    adc_divider_init(&divider, (uint32_t)length);
+    for (int r = 0; r < records; r++) {
+        results[r] = adc_batch_variance(block + (size_t)r * stride, length, &divider);
+    }
+    return 0;
+}
+
+//scratch至少length个int
+int adc_median_filter_block(const int *block, int records, int length, int stride, int *scratch, int *results) {
+    if (!adc_block_args_valid(block, records, length, stride) || scratch == NULL) {
+        return -1;
+    }
+    for (int r = 0; r < records; r++) {
+        memcpy(scratch, block + (size_t)r * stride, (size_t)length * sizeof(int));
+        results[r] = adc_select_kth(scratch, length, length / 2);
+    }
+    return 0;
+}
+
+//写一个可合并的统计量(count, mean, M2)：单线程用Welford逐个更新，分块结果用Chan的并行方差公式合并
+//方差取总体方差M2/n，与adc_variance_filter同口径(后者是整数截断版本)
+typedef struct {
+    int64_t count;
+    double mean;
+    double m2;
+} adc_stats_t;
+
+void adc_stats_init(adc_stats_t *stats) {
+    stats->count = 0;
+    stats->mean = 0;
+    stats->m2 = 0;
+}
+
+void adc_stats_push(adc_stats_t *stats, double value) {
+    stats->count++;
+    double delta = value - stats->mean;
+    stats->mean += delta / (double)stats->count;
+    stats->m2 += delta * (value - stats->mean);
+}
+
+//Chan等人的合并公式：delta = mean_b - mean_a，M2 = M2_a + M2_b + delta^2 * n_a * n_b / n
+void adc_stats_merge(adc_stats_t *into, const adc_stats_t *other) {
+    if (other->count == 0) {
+        return;
+    }
+    if (into->count == 0) {
+        *into = *other;
+        return;
+    }
+    int64_t count = into->count + other->count;
+    double delta = other->mean - into->mean;
+    into->mean += delta * (double)other->count / (double)count;
+    into->m2 += other->m2 + delta * delta * (double)into->count * (double)other->count / (double)count;
+    into->count = count;
+}
+
+double adc_stats_variance(const adc_stats_t *stats) {
+    return stats->count > 0 ? stats->m2 / (double)stats->count : 0;
+}
+
+//一块数据的统计量：以块内第一个采样K为偏移累加 d = x - K 的和与平方和(整数精确)，再换算成(mean, M2)
+//偏移后数值小，M2 = S2 - S1^2/n 的抵消误差可以忽略；要求|x| < 2^23(ADC数据都满足)，此时|d| < 2^24，块长不超过ADC_STATS_CHUNK(2^14)时平方和小于2^62
+#define ADC_STATS_CHUNK 16384
+
+static void adc_stats_chunk(const int *values, int length, adc_stats_t *stats) {
+    int64_t offset = values[0];
+    int64_t s1 = 0;
+    int64_t s2 = 0;
+    for (int i = 0; i < length; i++) {
+        int64_t d = values[i] - offset;
+        s1 += d;
+        s2 += d * d;
+    }
+    stats->count = length;
+    stats->mean = (double)offset + (double)s1 / length;
+    stats->m2 = (double)s2 - (double)s1 * (double)s1 / length;
+}
+
+//写一个多线程归约：大于1亿采样的离线数据按线程切分
+//threads <= 0 时使用在线CPU数；每个线程处理一段连续数据，最后在调用线程里合并
+#define ADC_MAX_THREADS 64
+
+typedef struct {
+    const int *values;
+    int64_t begin;
+    int64_t end;
+    int64_t sum;
+    uint64_t sum_squares;
+    adc_stats_t *chunk_stats;   //非NULL时按块计算统计量，下标为块号
+} adc_parallel_job_t;
+
+static int adc_parallel_threads(int threads, int64_t length) {
+    if (threads <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (int)online : 1;
+    }
+    if (threads > ADC_MAX_THREADS) {
+        threads = ADC_MAX_THREADS;
+    }
+    //每个线程至少分到一块，否则开线程不划算
+    int64_t useful = (length + ADC_STATS_CHUNK - 1) / ADC_STATS_CHUNK;
+    if (useful < threads) {
+        threads = useful > 0 ? (int)useful : 1;
+    }
+    return threads;
+}
+
+static void *adc_parallel_worker(void *arg) {
+    adc_parallel_job_t *job = arg;
+    for (int64_t start = job->begin; start < job->end; start += ADC_STATS_CHUNK) {
+        int length = (int)(job->end - start < ADC_STATS_CHUNK ? job->end - start : ADC_STATS_CHUNK);
+        const int *chunk = job->values + start;
+        if (job->chunk_stats != NULL) {
+            adc_stats_chunk(chunk, length, &job->chunk_stats[start / ADC_STATS_CHUNK]);
+        } else {
+            job->sum += adc_kernels->sum(chunk, length);
+            job->sum_squares += adc_kernels->sum_squares(chunk, length);
+        }
+    }
+    return NULL;
+}
+
+//按块边界把[0, length)平均切给threads个线程并等待完成，线程创建失败时由调用线程补做
+static void adc_parallel_run(const int *values, int64_t length, int threads, adc_stats_t *chunk_stats, adc_parallel_job_t *jobs) {
+    pthread_t handles[ADC_MAX_THREADS];
+    int started[ADC_MAX_THREADS];
+    int64_t chunks = (length + ADC_STATS_CHUNK - 1) / ADC_STATS_CHUNK;
+    for (int t = 0; t < threads; t++) {
+        jobs[t].values = values;
+        jobs[t].begin = chunks * t / threads * ADC_STATS_CHUNK;
+        jobs[t].end = t + 1 == threads ? length : chunks * (t + 1) / threads * ADC_STATS_CHUNK;
+        jobs[t].sum = 0;
+        jobs[t].sum_squares = 0;
+        jobs[t].chunk_stats = chunk_stats;
+    }
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&handles[t], NULL, adc_parallel_worker, &jobs[t]) == 0;
+    }
+    adc_parallel_worker(&jobs[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(handles[t], NULL);
+        } else {
+            adc_parallel_worker(&jobs[t]);
+        }
+    }
+}
+
+//并行Welford统计：先按固定大小的块各自计算，再按块号顺序合并，所以结果与线程数无关
+//与单线程逐个adc_stats_push的结果只差浮点舍入；分配失败返回-1
+int adc_stats_parallel(const int *values, int64_t length, int threads, adc_stats_t *stats) {
+    adc_parallel_job_t jobs[ADC_MAX_THREADS];
+    int64_t chunks = (length + ADC_STATS_CHUNK - 1) / ADC_STATS_CHUNK;
+    adc_stats_init(stats);
+    if (length <= 0) {
+        return 0;
+    }
+    adc_stats_t *chunk_stats = malloc((size_t)chunks * sizeof(adc_stats_t));
+    if (chunk_stats == NULL) {
+        return -1;
+    }
+    adc_parallel_run(values, length, adc_parallel_threads(threads, length), chunk_stats, jobs);
+    for (int64_t c = 0; c < chunks; c++) {
+        adc_stats_merge(stats, &chunk_stats[c]);
+    }
+    free(chunk_stats);
+    return 0;
+}
+
+//并行整数均值/方差：各线程精确累加和与平方和后合并，结果与adc_mean_filter、adc_variance_filter逐位一致
+int adc_mean_filter_parallel(const int *adc_values, int64_t length, int threads) {
+    adc_parallel_job_t jobs[ADC_MAX_THREADS];
+    int64_t sum = 0;
+    threads = adc_parallel_threads(threads, length);
+    adc_parallel_run(adc_values, length, threads, NULL, jobs);
+    for (int t = 0; t < threads; t++) {
+        sum += jobs[t].sum;
+    }
+    return (int)(sum / length);
+}
+
+int adc_variance_filter_parallel(const int *adc_values, int64_t length, int threads) {
+    adc_parallel_job_t jobs[ADC_MAX_THREADS];
+    int64_t sum = 0;
+    uint64_t sum_squares = 0;
+    threads = adc_parallel_threads(threads, length);
+    adc_parallel_run(adc_values, length, threads, NULL, jobs);
+    for (int t = 0; t < threads; t++) {
+        sum += jobs[t].sum;
+        sum_squares += jobs[t].sum_squares;
+    }
+    int64_t mean = sum / length;
+    int64_t variance = (int64_t)(sum_squares - 2 * (uint64_t)mean * (uint64_t)sum + (uint64_t)length * (uint64_t)mean * (uint64_t)mean);
+    return (int)(variance / length);
+}
+
+//写一个工作窃取线程池：每个工作线程一个双端队列，自己从尾部取(后进先出，缓存热)，空闲时从别人头部偷
+//submit把任务放进当前工作线程的队列(外部线程提交时轮流分配)，wait等待一组任务完成，等待期间调用者也帮忙执行任务
+//队列用互斥锁保护的环形缓冲，满了自动扩容；任务粒度在微秒以上时锁开销可以忽略
+typedef void (*adc_task_fn)(void *arg);
+
+typedef struct {
+    atomic_int remaining;
+} adc_task_group_t;
+
+typedef struct {
+    adc_task_fn fn;
+    void *arg;
+    adc_task_group_t *group;
+} adc_task_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    adc_task_t *tasks;
+    int capacity;
+    int head;       //偷的一端
+    int count;
+} adc_task_deque_t;
+
+typedef struct adc_task_pool {
+    int workers;
+    pthread_t threads[ADC_MAX_THREADS];
+    adc_task_deque_t deques[ADC_MAX_THREADS];
+    atomic_int queued;          //所有队列里的任务总数
+    atomic_int next_deque;      //外部线程提交时轮流选队列
+    int stop;
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake;
+    pthread_mutex_t done_lock;
+    pthread_cond_t done;        //任务组完成或有新任务入队时广播，唤醒wait里睡眠的线程
+    atomic_int waiters;         //正在done上睡眠(或准备睡眠)的线程数，为0时submit不必广播
+} adc_task_pool_t;
+
+static _Thread_local adc_task_pool_t *adc_current_pool;
+static _Thread_local int adc_current_worker = -1;
+
+static int adc_task_deque_push(adc_task_deque_t *deque, const adc_task_t *task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity) {
+        int capacity = deque->capacity > 0 ? deque->capacity * 2 : 64;
+        adc_task_t *tasks = malloc((size_t)capacity * sizeof(adc_task_t));
+        if (tasks == NULL) {
+            pthread_mutex_unlock(&deque->lock);
+            return -1;
+        }
+        for (int i = 0; i < deque->count; i++) {
+            tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->capacity = capacity;
+        deque->head = 0;
+    }
+    deque->tasks[(deque->head + deque->count) % deque->capacity] = *task;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+    return 0;
+}
+
+//from_tail为1时按后进先出取(队列主人)，为0时从头部偷
+static int adc_task_deque_take(adc_task_deque_t *deque, int from_tail, adc_task_t *task) {
+    int taken = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        if (from_tail) {
+            *task = deque->tasks[(deque->head + deque->count - 1) % deque->capacity];
+        } else {
+            *task = deque->tasks[deque->head];
+            deque->head = (deque->head + 1) % deque->capacity;
+        }
+        deque->count--;
+        taken = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return taken;
+}
+
+//先取自己的队列，再从下一个开始依次偷别人的
+static int adc_task_pool_take(adc_task_pool_t *pool, int self, adc_task_t *task) {
+    if (atomic_load(&pool->queued) == 0) {
+        return 0;
+    }
+    if (self >= 0 && adc_task_deque_take(&pool->deques[self], 1, task)) {
+        atomic_fetch_sub(&pool->queued, 1);
+        return 1;
+    }
+    for (int i = 1; i <= pool->workers; i++) {
+        int victim = (self + i + pool->workers) % pool->workers;
+        if (adc_task_deque_take(&pool->deques[victim], 0, task)) {
+            atomic_fetch_sub(&pool->queued, 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void adc_task_run(adc_task_pool_t *pool, const adc_task_t *task) {
+    task->fn(task->arg);
+    if (atomic_fetch_sub(&task->group->remaining, 1) == 1) {
+        pthread_mutex_lock(&pool->done_lock);
+        pthread_cond_broadcast(&pool->done);
+        pthread_mutex_unlock(&pool->done_lock);
+    }
+}
+
+typedef struct {
+    adc_task_pool_t *pool;
+    int index;
+} adc_worker_start_t;
+
+static void *adc_task_worker(void *arg) {
+    adc_worker_start_t *start = arg;
+    adc_task_pool_t *pool = start->pool;
+    int self = start->index;
+    adc_task_t task;
+    free(start);
+    adc_current_pool = pool;
+    adc_current_worker = self;
+    for (;;) {
+        if (adc_task_pool_take(pool, self, &task)) {
+            adc_task_run(pool, &task);
+            continue;
+        }
+        pthread_mutex_lock(&pool->sleep_lock);
+        while (atomic_load(&pool->queued) == 0 && !pool->stop) {
+            pthread_cond_wait(&pool->wake, &pool->sleep_lock);
+        }
+        int stop = pool->stop && atomic_load(&pool->queued) == 0;
+        pthread_mutex_unlock(&pool->sleep_lock);
+        if (stop) {
+            return NULL;
+        }
+    }
+}
+
+void adc_task_pool_destroy(adc_task_pool_t *pool);
+
+//workers <= 0 时使用在线CPU数，失败返回NULL
+adc_task_pool_t *adc_task_pool_create(int workers) {
+    if (workers <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = online > 0 ? (int)online : 1;
+    }
+    if (workers > ADC_MAX_THREADS) {
+        workers = ADC_MAX_THREADS;
+    }
+    adc_task_pool_t *pool = calloc(1, sizeof(adc_task_pool_t));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&pool->sleep_lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_mutex_init(&pool->done_lock, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->next_deque, 0);
+    atomic_init(&pool->waiters, 0);
+    for (int i = 0; i < ADC_MAX_THREADS; i++) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+    }
+    pool->workers = workers;
+    for (int i = 0; i < workers; i++) {
+        adc_worker_start_t *start = malloc(sizeof(adc_worker_start_t));
+        if (start == NULL) {
+            pool->workers = i;
+            adc_task_pool_destroy(pool);
+            return NULL;
+        }
+        start->pool = pool;
+        start->index = i;
+        if (pthread_create(&pool->threads[i], NULL, adc_task_worker, start) != 0) {
+            free(start);
+            pool->workers = i;
+            adc_task_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+//等队列里剩余任务执行完后停止所有工作线程
+void adc_task_pool_destroy(adc_task_pool_t *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->sleep_lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->sleep_lock);
+    for (int i = 0; i < pool->workers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (int i = 0; i < ADC_MAX_THREADS; i++) {
+        free(pool->deques[i].tasks);
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    pthread_mutex_destroy(&pool->sleep_lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->done_lock);
+    pthread_cond_destroy(&pool->done);
+    free(pool);
+}
+
+int adc_task_pool_workers(const adc_task_pool_t *pool) {
+    return pool->workers;
+}
+
+void adc_task_group_init(adc_task_group_t *group) {
+    atomic_init(&group->remaining, 0);
+}
+
+//提交一个任务，任务里可以继续提交(会进入当前工作线程自己的队列)；内存不足时直接在调用线程执行
+void adc_task_pool_submit(adc_task_pool_t *pool, adc_task_group_t *group, adc_task_fn fn, void *arg) {
+    adc_task_t task = {fn, arg, group};
+    int target = adc_current_pool == pool ? adc_current_worker : atomic_fetch_add(&pool->next_deque, 1) % pool->workers;
+    if (target < 0) {
+        target += pool->workers;
+    }
+    atomic_fetch_add(&group->remaining, 1);
+    if (adc_task_deque_push(&pool->deques[target], &task) != 0) {
+        adc_task_run(pool, &task);
+        return;
+    }
+    atomic_fetch_add(&pool->queued, 1);
+    pthread_mutex_lock(&pool->sleep_lock);
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->sleep_lock);
+    //wait里睡眠的线程(可能是在任务里等子任务的工作线程)也要醒来帮忙，否则工作线程都在等时没人执行新任务
+    //waiters先加再查queued，这里先加queued再查waiters，两边都是顺序一致的原子操作，不会漏掉唤醒
+    if (atomic_load(&pool->waiters) > 0) {
+        pthread_mutex_lock(&pool->done_lock);
+        pthread_cond_broadcast(&pool->done);
+        pthread_mutex_unlock(&pool->done_lock);
+    }
+}
+
+//等待group里的任务全部完成，期间帮忙执行队列里的任务
+void adc_task_pool_wait(adc_task_pool_t *pool, adc_task_group_t *group) {
+    int self = adc_current_pool == pool ? adc_current_worker : -1;
+    adc_task_t task;
+    while (atomic_load(&group->remaining) > 0) {
+        if (adc_task_pool_take(pool, self, &task)) {
+            adc_task_run(pool, &task);
+            continue;
+        }
+        //组内最后一个任务完成时adc_task_run广播done，有新任务入队时submit也会广播，所以不需要超时
+        pthread_mutex_lock(&pool->done_lock);
+        atomic_fetch_add(&pool->waiters, 1);
+        while (atomic_load(&group->remaining) > 0 && atomic_load(&pool->queued) == 0) {
+            pthread_cond_wait(&pool->done, &pool->done_lock);
+        }
+        atomic_fetch_sub(&pool->waiters, 1);
+        pthread_mutex_unlock(&pool->done_lock);
+    }
+}
+
+//把[0, count)按grain切成区间交给线程池，body(ctx, begin, end)处理一个区间，返回前全部完成
+typedef struct {
+    void (*body)(void *ctx, int begin, int end);
+    void *ctx;
+    int begin;
+    int end;
+} adc_parallel_range_t;
+
+static void adc_parallel_range_task(void *arg) {
+    adc_parallel_range_t *range = arg;
+    range->body(range->ctx, range->begin, range->end);
+}
+
+void adc_task_pool_parallel_for(adc_task_pool_t *pool, int count, int grain, void (*body)(void *ctx, int begin, int end), void *ctx) {
+    adc_task_group_t group;
+    if (grain < 1) {
+        grain = 1;
+    }
+    int tasks = (count + grain - 1) / grain;
+    if (pool == NULL || tasks <= 1) {
+        if (count > 0) {
+            body(ctx, 0, count);
+        }
+        return;
+    }
+    adc_parallel_range_t *ranges = malloc((size_t)tasks * sizeof(adc_parallel_range_t));
+    if (ranges == NULL) {
+        body(ctx, 0, count);
+        return;
+    }
+    adc_task_group_init(&group);
+    for (int t = 0; t < tasks; t++) {
+        ranges[t].body = body;
+        ranges[t].ctx = ctx;
+        ranges[t].begin = t * grain;
+        ranges[t].end = t * grain + grain < count ? t * grain + grain : count;
+        adc_task_pool_submit(pool, &group, adc_parallel_range_task, &ranges[t]);
+    }
+    adc_task_pool_wait(pool, &group);
+    free(ranges);
+}
+
+//批量接口和多通道接口的线程池版本，结果与单线程版本一致
+typedef struct {
+    const adc_record_t *records;
+    int *results;
+    int kind;       //0均值 1方差 2中值
+    atomic_int failed;  //某个任务分配临时空间失败时置1，这部分结果没有写入
+} adc_batch_job_t;
+
+static void adc_batch_range(void *ctx, int begin, int end) {
+    adc_batch_job_t *job = ctx;
+    const adc_record_t *records = job->records + begin;
+    int count = end - begin;
+    if (job->kind == 0) {
+        adc_mean_filter_batch(records, count, job->results + begin);
+    } else if (job->kind == 1) {
+        adc_variance_filter_batch(records, count, job->results + begin);
+    } else {
+        int longest = 1;
+        for (int r = 0; r < count; r++) {
+            longest = records[r].length > longest ? records[r].length : longest;
+        }
+        int *scratch = malloc((size_t)longest * sizeof(int));
+        if (scratch == NULL) {
+            atomic_store(&job->failed, 1);
+            return;
+        }
+        adc_median_filter_batch(records, count, scratch, job->results + begin);
+        free(scratch);
+    }
+}
+
+static int adc_batch_parallel(adc_task_pool_t *pool, const adc_record_t *records, int count, int *results, int kind) {
+    if (!adc_records_valid(records, count)) {
+        return -1;
+    }
+    adc_batch_job_t job;
+    job.records = records;
+    job.results = results;
+    job.kind = kind;
+    atomic_init(&job.failed, 0);
+    adc_task_pool_parallel_for(pool, count, 256, adc_batch_range, &job);
+    return atomic_load(&job.failed) ? -1 : 0;
+}
+
+int adc_mean_filter_batch_parallel(adc_task_pool_t *pool, const adc_record_t *records, int count, int *results) {
+    return adc_batch_parallel(pool, records, count, results, 0);
+}
+
+int adc_variance_filter_batch_parallel(adc_task_pool_t *pool, const adc_record_t *records, int count, int *results) {
+    return adc_batch_parallel(pool, records, count, results, 1);
+}
+
+//中值的临时空间由每个任务自己分配，分配失败时返回-1
+int adc_median_filter_batch_parallel(adc_task_pool_t *pool, const adc_record_t *records, int count, int *results) {
+    return adc_batch_parallel(pool, records, count, results, 2);
+}
+
+//多通道：按帧切段，各段在局部数组里累加所有通道的和与平方和，最后按段号顺序合并
+#define ADC_INTERLEAVED_GRAIN 65536
+
+typedef struct {
+    const int *values;
+    int channels;
+    int stride;
+    int64_t (*sums)[ADC_MAX_CHANNELS];
+    int64_t (*sum_squares)[ADC_MAX_CHANNELS];
+} adc_interleaved_job_t;
+
+//按ADC_INTERLEAVED_GRAIN对齐的段逐段写结果，线程池退回成一次整体调用时所有段也都会被写到
+static void adc_interleaved_range(void *ctx, int begin, int end) {
+    adc_interleaved_job_t *job = ctx;
+    for (int start = begin; start < end; start += ADC_INTERLEAVED_GRAIN) {
+        int stop = end - start < ADC_INTERLEAVED_GRAIN ? end : start + ADC_INTERLEAVED_GRAIN;
+        int64_t sums[ADC_MAX_CHANNELS] = {0};
+        int64_t sum_squares[ADC_MAX_CHANNELS] = {0};
+        for (int f = start; f < stop; f++) {
+            const int *frame = job->values + (size_t)f * job->stride;
+            for (int ch = 0; ch < job->channels; ch++) {
+                int64_t value = frame[ch];
+                sums[ch] += value;
+                sum_squares[ch] += value * value;
+            }
+        }
+        memcpy(job->sums[start / ADC_INTERLEAVED_GRAIN], sums, sizeof(sums));
+        memcpy(job->sum_squares[start / ADC_INTERLEAVED_GRAIN], sum_squares, sizeof(sum_squares));
+    }
+}
+
+static int adc_interleaved_parallel(adc_task_pool_t *pool, const int *adc_values, int frames, int channels, int stride, int *means, int *variances) {
+    if (!adc_interleaved_args_valid(frames, channels, stride)) {
+        return -1;
+    }
+    int segments = (frames + ADC_INTERLEAVED_GRAIN - 1) / ADC_INTERLEAVED_GRAIN;
+    adc_interleaved_job_t job = {adc_values, channels, stride, NULL, NULL};
+    job.sums = calloc((size_t)segments, sizeof(*job.sums));
+    job.sum_squares = calloc((size_t)segments, sizeof(*job.sum_squares));
+    if (job.sums == NULL || job.sum_squares == NULL) {
+        free(job.sums);
+        free(job.sum_squares);
+        return -1;
+    }
+    adc_task_pool_parallel_for(pool, frames, ADC_INTERLEAVED_GRAIN, adc_interleaved_range, &job);
+    for (int ch = 0; ch < channels; ch++) {
+        int64_t sum = 0;
+        int64_t sum_square = 0;
+        for (int s = 0; s < segments; s++) {
+            sum += job.sums[s][ch];
+            sum_square += job.sum_squares[s][ch];
+        }
+        int64_t mean = sum / frames;
+        if (means != NULL) {
+            means[ch] = (int)mean;
+        }
+        if (variances != NULL) {
+            variances[ch] = (int)((sum_square - 2 * mean * sum + (int64_t)frames * mean * mean) / frames);
+        }
+    }
+    free(job.sums);
+    free(job.sum_squares);
+    return 0;
+}
+
+int adc_mean_filter_interleaved_parallel(adc_task_pool_t *pool, const int *adc_values, int frames, int channels, int stride, int *means) {
+    return adc_interleaved_parallel(pool, adc_values, frames, channels, stride, means, NULL);
+}
+
+int adc_variance_filter_interleaved_parallel(adc_task_pool_t *pool, const int *adc_values, int frames, int channels, int stride, int *variances) {
+    return adc_interleaved_parallel(pool, adc_values, frames, channels, stride, NULL, variances);
+}
+
+//写一个定点二阶IIR级联(biquad)，给ADC和PPG在均值/方差/自适应阈值统计之前做低通、高通、带通和陷波
+//系数为Q31格式再右移post_shift位(即Q(31-post_shift))，post_shift=1时系数范围[-2, 2)，足够放下a1和高通的b1
+//乘法32x32->64，累加64位，不饱和(与CMSIS arm_biquad_cascade_df1_q31同规则)；每个通道每节一份状态，由调用者提供内存
+//DF-I：状态[x1, x2, y1, y2]为int32，量化只发生在输出，低截止频率时更稳；DF-II转置：状态为两个int64，少一半乘前数据搬移
+//多通道交织数据用adc_biquad_df1_process_interleaved，每4个相邻通道走一次SIMD核(AVX2/NEON)
+typedef struct {
+    int stages;
+    int channels;
+    int shift;                          //31 - post_shift
+    const adc_biquad_coeffs_t *coeffs;  //stages节，第0节先处理
+    int32_t *state;                     //stages * channels * 4
+} adc_biquad_df1_t;
+
+typedef struct {
+    int stages;
+    int channels;
+    int shift;
+    const adc_biquad_coeffs_t *coeffs;
+    int64_t *state;                     //stages * channels * 2
+} adc_biquad_df2t_t;
+
+//离线用RBJ cookbook公式设计、量化到Q30(post_shift = 1)的常用系数表，4阶Butterworth拆成两节(Q = 0.5412, 1.3066)
+//ADC：1 kHz采样，50 Hz低通
+const adc_biquad_coeffs_t adc_biquad_lowpass_fs1000_50hz[2] = {
+    {20440642, 40881285, 20440642, -1588788093, 596808838},
+    {23497607, 46995214, 23497607, -1826396544, 846645149},
+};
+
+//PPG：100 Hz采样，0.5 Hz高通去基线漂移
+const adc_biquad_coeffs_t adc_biquad_highpass_fs100_0p5hz[2] = {
+    {1043203401, -2086406802, 1043203401, -2085891917, 1013179863},
+    {1060726577, -2121453154, 1060726577, -2120929621, 1048234864},
+};
+
+//PPG：100 Hz采样，0.5~5 Hz带通(二阶高通 + 二阶低通，Q = 0.7071)，覆盖30~300 BPM
+const adc_biquad_coeffs_t adc_biquad_bandpass_fs100_0p5_5hz[2] = {
+    {1050152231, -2100304461, 1050152231, -2099786147, 1027080952},
+    {21564350, 43128699, 21564350, -1676130396, 688645970},
+};
+
+//ADC：1 kHz采样，50 Hz工频陷波(Q = 30)
+const adc_biquad_coeffs_t adc_biquad_notch_fs1000_50hz[1] = {
+    {1068240085, -2031913388, 1068240085, -2031913388, 1062738346},
+};
+
+int adc_biquad_df1_init(adc_biquad_df1_t *filter, const adc_biquad_coeffs_t *coeffs, int stages, int post_shift, int channels, int32_t *state) {
+    if (stages < 1 || channels < 1 || post_shift < 0 || post_shift > 30 || state == NULL) {
+        return -1;
+    }
+    filter->stages = stages;
+    filter->channels = channels;
+    filter->shift = 31 - post_shift;
+    filter->coeffs = coeffs;
+    filter->state = state;
+    memset(state, 0, (size_t)stages * channels * 4 * sizeof(int32_t));
+    return 0;
+}
+
+//单个通道处理一块数据，output可以等于input
+void adc_biquad_df1_process(adc_biquad_df1_t *filter, int channel, const int32_t *input, int32_t *output, int length) {
+    for (int s = 0; s < filter->stages; s++) {
+        int32_t *state = filter->state + ((size_t)s * filter->channels + channel) * 4;
+        adc_biquad_df1_stage(&filter->coeffs[s], filter->shift, state, s == 0 ? input : output, output, length, 1);
+    }
+}
+
+//交织的多通道数据(每帧channels个采样)，逐节处理整块；4个一组的通道走SIMD，剩下的走标量
+void adc_biquad_df1_process_interleaved(adc_biquad_df1_t *filter, const int32_t *input, int32_t *output, int frames) {
+    int channels = filter->channels;
+    for (int s = 0; s < filter->stages; s++) {
+        const int32_t *source = s == 0 ? input : output;
+        int32_t *state = filter->state + (size_t)s * channels * 4;
+        int ch = 0;
+        for (; ch + 4 <= channels; ch += 4) {
+            adc_kernels->biquad_x4(&filter->coeffs[s], filter->shift, state + ch * 4, source + ch, output + ch, frames, channels);
+        }
+        for (; ch < channels; ch++) {
+            adc_biquad_df1_stage(&filter->coeffs[s], filter->shift, state + ch * 4, source + ch, output + ch, frames, channels);
+        }
+    }
+}
+
+int adc_biquad_df2t_init(adc_biquad_df2t_t *filter, const adc_biquad_coeffs_t *coeffs, int stages, int post_shift, int channels, int64_t *state) {
+    if (stages < 1 || channels < 1 || post_shift < 0 || post_shift > 30 || state == NULL) {
+        return -1;
+    }
+    filter->stages = stages;
+    filter->channels = channels;
+    filter->shift = 31 - post_shift;
+    filter->coeffs = coeffs;
+    filter->state = state;
+    memset(state, 0, (size_t)stages * channels * 2 * sizeof(int64_t));
+    return 0;
+}
+
+//DF-II转置：y = (b0*x + s1) >> shift，s1 = b1*x - a1*y + s2，s2 = b2*x - a2*y，状态保持在累加器精度
+void adc_biquad_df2t_process(adc_biquad_df2t_t *filter, int channel, const int32_t *input, int32_t *output, int length) {
+    for (int s = 0; s < filter->stages; s++) {
+        const adc_biquad_coeffs_t *c = &filter->coeffs[s];
+        int64_t *state = filter->state + ((size_t)s * filter->channels + channel) * 2;
+        const int32_t *source = s == 0 ? input : output;
+        uint64_t s1 = (uint64_t)state[0];
+        uint64_t s2 = (uint64_t)state[1];
+        for (int i = 0; i < length; i++) {
+            int64_t x = source[i];
+            int32_t y = (int32_t)(uint32_t)(((uint64_t)(c->b0 * x) + s1) >> filter->shift);
+            s1 = (uint64_t)(c->b1 * x) - (uint64_t)((int64_t)c->a1 * y) + s2;
+            s2 = (uint64_t)(c->b2 * x) - (uint64_t)((int64_t)c->a2 * y);
+            output[i] = y;
+        }
+        state[0] = (int64_t)s1;
+        state[1] = (int64_t)s2;
+    }
+}
+
+//写一个FIR滤波引擎，替代各处手写的平滑/重采样循环，支持任意抽头数、Q15和float两种采样
+//延迟线用双写环形缓存：每个采样同时写到pos和pos+taps，窗口[pos, pos+taps)总是连续的，不需要memmove，
+//内积直接走adc_kernels里的AVX2/NEON实现；系数在init时按相位拆分并倒序存放，使窗口从旧到新与系数逐项对应
+//多相结构：抽取M时每输入M个采样只算一次内积(其余输出根本不计算)，插值L时每个输入采样算L个相位各自的短内积
+//抽取和插值二选一(另一个填1)；插值时零值插入带来的1/L增益需要在系数里补偿
+//调用者提供内存：coeffs需要adc_fir_coeff_length(num_taps, interpolation)个元素，delay需要其2倍
+typedef struct {
+    int taps;           //每个相位的抽头数 = ceil(num_taps / interpolation)
+    int decimation;
+    int interpolation;
+    int pos;            //下一个采样写入的位置
+    int pending;        //抽取模式下自上次输出以来已输入的采样数
+    int16_t *coeffs;    //interpolation * taps，每个相位倒序
+    int16_t *delay;     //2 * taps
+} adc_fir_q15_t;
+
+typedef struct {
+    int taps;
+    int decimation;
+    int interpolation;
+    int pos;
+    int pending;
+    float *coeffs;
+    float *delay;
+} adc_fir_f32_t;
+
+int adc_fir_coeff_length(int num_taps, int interpolation) {
+    return (num_taps + interpolation - 1) / interpolation * interpolation;
+}
+
+static int adc_fir_args_valid(int num_taps, int decimation, int interpolation) {
+    return num_taps > 0 && decimation > 0 && interpolation > 0 && (decimation == 1 || interpolation == 1);
+}
+
+//相位p的第k个抽头是原型滤波器的h[p + k*L]，倒序存放，超出num_taps的部分补零
+int adc_fir_q15_init(adc_fir_q15_t *fir, const int16_t *coeffs, int num_taps, int decimation, int interpolation,
+                     int16_t *coeff_storage, int16_t *delay_storage) {
+    if (!adc_fir_args_valid(num_taps, decimation, interpolation)) {
+        return -1;
+    }
+    //-32768会让AVX2成对乘加溢出int32，Q15系数本来就到不了-1.0
+    for (int i = 0; i < num_taps; i++) {
+        if (coeffs[i] == INT16_MIN) {
+            return -1;
+        }
+    }
+    fir->taps = (num_taps + interpolation - 1) / interpolation;
+    fir->decimation = decimation;
+    fir->interpolation = interpolation;
+    fir->pos = 0;
+    fir->pending = 0;
+    fir->coeffs = coeff_storage;
+    fir->delay = delay_storage;
+    for (int p = 0; p < interpolation; p++) {
+        for (int k = 0; k < fir->taps; k++) {
+            int index = p + k * interpolation;
+            coeff_storage[p * fir->taps + fir->taps - 1 - k] = index < num_taps ? coeffs[index] : 0;
+        }
+    }
+    memset(delay_storage, 0, (size_t)2 * fir->taps * sizeof(int16_t));
+    return 0;
+}
+
+int adc_fir_f32_init(adc_fir_f32_t *fir, const float *coeffs, int num_taps, int decimation, int interpolation,
+                     float *coeff_storage, float *delay_storage) {
+    if (!adc_fir_args_valid(num_taps, decimation, interpolation)) {
+        return -1;
+    }
+    fir->taps = (num_taps + interpolation - 1) / interpolation;
+    fir->decimation = decimation;
+    fir->interpolation = interpolation;
+    fir->pos = 0;
+    fir->pending = 0;
+    fir->coeffs = coeff_storage;
+    fir->delay = delay_storage;
+    for (int p = 0; p < interpolation; p++) {
+        for (int k = 0; k < fir->taps; k++) {
+            int index = p + k * interpolation;
+            coeff_storage[p * fir->taps + fir->taps - 1 - k] = index < num_taps ? coeffs[index] : 0.0f;
+        }
+    }
+    memset(delay_storage, 0, (size_t)2 * fir->taps * sizeof(float));
+    return 0;
+}
+
+//Q15输出：累加值右移15位后饱和到int16
+static int16_t adc_fir_q15_output(int64_t acc) {
+    acc >>= 15;
+    return (int16_t)(acc > INT16_MAX ? INT16_MAX : acc < INT16_MIN ? INT16_MIN : acc);
+}
+
+//处理length个输入，返回写入output的输出个数：全速率为length，抽取约length/M，插值为length*L
+int adc_fir_q15_process(adc_fir_q15_t *fir, const int16_t *input, int length, int16_t *output) {
+    int taps = fir->taps;
+    int produced = 0;
+    for (int i = 0; i < length; i++) {
+        fir->delay[fir->pos] = input[i];
+        fir->delay[fir->pos + taps] = input[i];
+        fir->pos = fir->pos + 1 == taps ? 0 : fir->pos + 1;
+        const int16_t *window = fir->delay + fir->pos;
+        if (fir->interpolation > 1) {
+            for (int p = 0; p < fir->interpolation; p++) {
+                output[produced++] = adc_fir_q15_output(adc_kernels->dot_q15(fir->coeffs + p * taps, window, taps));
+            }
+        } else if (++fir->pending == fir->decimation) {
+            fir->pending = 0;
+            output[produced++] = adc_fir_q15_output(adc_kernels->dot_q15(fir->coeffs, window, taps));
+        }
+    }
+    return produced;
+}
+
+int adc_fir_f32_process(adc_fir_f32_t *fir, const float *input, int length, float *output) {
+    int taps = fir->taps;
+    int produced = 0;
+    for (int i = 0; i < length; i++) {
+        fir->delay[fir->pos] = input[i];
+        fir->delay[fir->pos + taps] = input[i];
+        fir->pos = fir->pos + 1 == taps ? 0 : fir->pos + 1;
+        const float *window = fir->delay + fir->pos;
+        if (fir->interpolation > 1) {
+            for (int p = 0; p < fir->interpolation; p++) {
+                output[produced++] = adc_kernels->dot_f32(fir->coeffs + p * taps, window, taps);
+            }
+        } else if (++fir->pending == fir->decimation) {
+            fir->pending = 0;
+            output[produced++] = adc_kernels->dot_f32(fir->coeffs, window, taps);
+        }
+    }
+    return produced;
+}
+
+//写一个实数FFT，给PPG做频域心率估计(与adaptive_threshold_algorithm互相校验)，也用来查ADC通道里的工频干扰
+//N点实数序列按N/2点复数序列(偶数采样为实部、奇数为虚部)做复数FFT，再用一步拆分得到N/2+1个频点
+//复数FFT先做位反转重排，再每次合并两级radix-2蝶形为一级radix-4(log2(N/2)为奇数时先单独做一级radix-2)，访存遍数减半
+//旋转因子、拆分因子、位反转表、Hann窗和Welch工作区都在plan里一次分配好，变换本身原地进行、不分配内存
+//输出排布(原地)：[X0实部, X(N/2)实部, X1实部, X1虚部, X2实部, X2虚部, ...]，两端点为纯实数
+//Q15版本每级蝶形右移1位防止溢出，输出为X/N；float版本不缩放
+//plan本身只读，可以多线程共用做变换；adc_welch_psd会用plan里的工作区，同一个plan不能同时跑两个Welch
+#define ADC_PI 3.14159265358979323846
+#define ADC_FFT_MIN_SIZE 64
+#define ADC_FFT_MAX_SIZE 65536
+
+typedef struct {
+    int size;             //实数点数N
+    int log2_half;        //log2(N/2)
+    int *bit_reverse;     //N/2
+    float *twiddle;       //N/2个复数W_(N/2)^m，交织存放cos、-sin
+    float *split;         //N/2个复数W_N^k
+    int16_t *twiddle_q15;
+    int16_t *split_q15;
+    float *window;        //N点Hann窗
+    float *work;          //N，Welch分段用
+    double window_power;  //窗的平方和
+} adc_fft_plan_t;
+
+void adc_fft_plan_destroy(adc_fft_plan_t *plan) {
+    if (plan == NULL) {
+        return;
+    }
+    free(plan->bit_reverse);
+    free(plan->twiddle);
+    free(plan->split);
+    free(plan->twiddle_q15);
+    free(plan->split_q15);
+    free(plan->window);
+    free(plan->work);
+    free(plan);
+}
+
+adc_fft_plan_t *adc_fft_plan_create(int size) {
+    if (size < ADC_FFT_MIN_SIZE || size > ADC_FFT_MAX_SIZE || (size & (size - 1)) != 0) {
+        return NULL;
+    }
+    int half = size / 2;
+    adc_fft_plan_t *plan = calloc(1, sizeof(adc_fft_plan_t));
+    if (plan == NULL) {
+        return NULL;
+    }
+    plan->size = size;
+    while ((1 << plan->log2_half) < half) {
+        plan->log2_half++;
+    }
+    plan->bit_reverse = malloc((size_t)half * sizeof(int));
+    plan->twiddle = malloc((size_t)size * sizeof(float));
+    plan->split = malloc((size_t)size * sizeof(float));
+    plan->twiddle_q15 = malloc((size_t)size * sizeof(int16_t));
+    plan->split_q15 = malloc((size_t)size * sizeof(int16_t));
+    plan->window = malloc((size_t)size * sizeof(float));
+    plan->work = malloc((size_t)size * sizeof(float));
+    if (plan->bit_reverse == NULL || plan->twiddle == NULL || plan->split == NULL || plan->twiddle_q15 == NULL ||
+        plan->split_q15 == NULL || plan->window == NULL || plan->work == NULL) {
+        adc_fft_plan_destroy(plan);
+        return NULL;
+    }
+    for (int i = 0; i < half; i++) {
+        int reversed = 0;
+        for (int bit = 0; bit < plan->log2_half; bit++) {
+            reversed |= ((i >> bit) & 1) << (plan->log2_half - 1 - bit);
+        }
+        plan->bit_reverse[i] = reversed;
+        double angle = 2 * ADC_PI * i / half;
+        plan->twiddle[2 * i] = (float)cos(angle);
+        plan->twiddle[2 * i + 1] = (float)-sin(angle);
+        plan->twiddle_q15[2 * i] = (int16_t)lrint(cos(angle) * 32767);
+        plan->twiddle_q15[2 * i + 1] = (int16_t)lrint(-sin(angle) * 32767);
+        angle = 2 * ADC_PI * i / size;
+        plan->split[2 * i] = (float)cos(angle);
+        plan->split[2 * i + 1] = (float)-sin(angle);
+        plan->split_q15[2 * i] = (int16_t)lrint(cos(angle) * 32767);
+        plan->split_q15[2 * i + 1] = (int16_t)lrint(-sin(angle) * 32767);
+    }
+    plan->window_power = 0;
+    for (int i = 0; i < size; i++) {
+        plan->window[i] = (float)(0.5 - 0.5 * cos(2 * ADC_PI * i / size));
+        plan->window_power += (double)plan->window[i] * plan->window[i];
+    }
+    return plan;
+}
+
+//N/2点复数FFT，data为交织的实部、虚部
+static void adc_fft_complex(const adc_fft_plan_t *plan, float *data) {
+    int half = plan->size / 2;
+    for (int i = 0; i < half; i++) {
+        int j = plan->bit_reverse[i];
+        if (i < j) {
+            float re = data[2 * i], im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+    int span = 1;
+    if (plan->log2_half & 1) {
+        for (int i = 0; i < half; i += 2) {
+            float ar = data[2 * i], ai = data[2 * i + 1];
+            float br = data[2 * i + 2], bi = data[2 * i + 3];
+            data[2 * i] = ar + br;
+            data[2 * i + 1] = ai + bi;
+            data[2 * i + 2] = ar - br;
+            data[2 * i + 3] = ai - bi;
+        }
+        span = 2;
+    }
+    //一次做跨度span和2*span两级：第一级旋转因子W_(2span)^k = w^2，第二级W_(4span)^k = w，后半组再乘-i
+    for (; span < half; span *= 4) {
+        int stride = half / (4 * span);
+        for (int group = 0; group < half; group += 4 * span) {
+            for (int k = 0; k < span; k++) {
+                float w2r = plan->twiddle[2 * k * stride], w2i = plan->twiddle[2 * k * stride + 1];
+                float w1r = plan->twiddle[4 * k * stride], w1i = plan->twiddle[4 * k * stride + 1];
+                float *a = data + 2 * (group + k);
+                float *b = a + 2 * span;
+                float *c = b + 2 * span;
+                float *d = c + 2 * span;
+                float tr = w1r * b[0] - w1i * b[1], ti = w1r * b[1] + w1i * b[0];
+                float ur = w1r * d[0] - w1i * d[1], ui = w1r * d[1] + w1i * d[0];
+                float a1r = a[0] + tr, a1i = a[1] + ti, b1r = a[0] - tr, b1i = a[1] - ti;
+                float c1r = c[0] + ur, c1i = c[1] + ui, d1r = c[0] - ur, d1i = c[1] - ui;
+                tr = w2r * c1r - w2i * c1i;
+                ti = w2r * c1i + w2i * c1r;
+                //(-i) * w * d1
+                ur = w2r * d1i + w2i * d1r;
+                ui = -(w2r * d1r - w2i * d1i);
+                a[0] = a1r + tr;
+                a[1] = a1i + ti;
+                c[0] = a1r - tr;
+                c[1] = a1i - ti;
+                b[0] = b1r + ur;
+                b[1] = b1i + ui;
+                d[0] = b1r - ur;
+                d[1] = b1i - ui;
+            }
+        }
+    }
+}
+
+//原地实数FFT，data为N个实数采样，输出排布见上
+void adc_fft_real(const adc_fft_plan_t *plan, float *data) {
+    int half = plan->size / 2;
+    adc_fft_complex(plan, data);
+    float re0 = data[0], im0 = data[1];
+    data[0] = re0 + im0;
+    data[1] = re0 - im0;
+    //X[k] = E + W_N^k * O，X[N/2-k] = conj(E - W_N^k * O)，E = (Z[k] + conj(Z[N/2-k])) / 2，O = -i(Z[k] - conj(Z[N/2-k])) / 2
+    for (int k = 1; k <= half / 2; k++) {
+        float *zk = data + 2 * k;
+        float *zm = data + 2 * (half - k);
+        float er = 0.5f * (zk[0] + zm[0]), ei = 0.5f * (zk[1] - zm[1]);
+        float or_ = 0.5f * (zk[1] + zm[1]), oi = -0.5f * (zk[0] - zm[0]);
+        float wr = plan->split[2 * k], wi = plan->split[2 * k + 1];
+        float tr = wr * or_ - wi * oi, ti = wr * oi + wi * or_;
+        zk[0] = er + tr;
+        zk[1] = ei + ti;
+        zm[0] = er - tr;
+        zm[1] = -(ei - ti);
+    }
+}
+
+//Q15乘法，四舍五入
+static int32_t adc_q15_mul(int32_t a, int32_t b) {
+    return (a * b + (1 << 14)) >> 15;
+}
+
+static void adc_fft_complex_q15(const adc_fft_plan_t *plan, int16_t *data) {
+    int half = plan->size / 2;
+    for (int i = 0; i < half; i++) {
+        int j = plan->bit_reverse[i];
+        if (i < j) {
+            int16_t re = data[2 * i], im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+    int span = 1;
+    if (plan->log2_half & 1) {
+        for (int i = 0; i < half; i += 2) {
+            int32_t ar = data[2 * i], ai = data[2 * i + 1];
+            int32_t br = data[2 * i + 2], bi = data[2 * i + 3];
+            data[2 * i] = (int16_t)((ar + br) >> 1);
+            data[2 * i + 1] = (int16_t)((ai + bi) >> 1);
+            data[2 * i + 2] = (int16_t)((ar - br) >> 1);
+            data[2 * i + 3] = (int16_t)((ai - bi) >> 1);
+        }
+        span = 2;
+    }
+    for (; span < half; span *= 4) {
+        int stride = half / (4 * span);
+        for (int group = 0; group < half; group += 4 * span) {
+            for (int k = 0; k < span; k++) {
+                int32_t w2r = plan->twiddle_q15[2 * k * stride], w2i = plan->twiddle_q15[2 * k * stride + 1];
+                int32_t w1r = plan->twiddle_q15[4 * k * stride], w1i = plan->twiddle_q15[4 * k * stride + 1];
+                int16_t *a = data + 2 * (group + k);
+                int16_t *b = a + 2 * span;
+                int16_t *c = b + 2 * span;
+                int16_t *d = c + 2 * span;
+                int32_t tr = adc_q15_mul(w1r, b[0]) - adc_q15_mul(w1i, b[1]), ti = adc_q15_mul(w1r, b[1]) + adc_q15_mul(w1i, b[0]);
+                int32_t ur = adc_q15_mul(w1r, d[0]) - adc_q15_mul(w1i, d[1]), ui = adc_q15_mul(w1r, d[1]) + adc_q15_mul(w1i, d[0]);
+                int32_t a1r = (a[0] + tr) >> 1, a1i = (a[1] + ti) >> 1, b1r = (a[0] - tr) >> 1, b1i = (a[1] - ti) >> 1;
+                int32_t c1r = (c[0] + ur) >> 1, c1i = (c[1] + ui) >> 1, d1r = (c[0] - ur) >> 1, d1i = (c[1] - ui) >> 1;
+                tr = adc_q15_mul(w2r, c1r) - adc_q15_mul(w2i, c1i);
+                ti = adc_q15_mul(w2r, c1i) + adc_q15_mul(w2i, c1r);
+                ur = adc_q15_mul(w2r, d1i) + adc_q15_mul(w2i, d1r);
+                ui = -(adc_q15_mul(w2r, d1r) - adc_q15_mul(w2i, d1i));
+                a[0] = (int16_t)((a1r + tr) >> 1);
+                a[1] = (int16_t)((a1i + ti) >> 1);
+                c[0] = (int16_t)((a1r - tr) >> 1);
+                c[1] = (int16_t)((a1i - ti) >> 1);
+                b[0] = (int16_t)((b1r + ur) >> 1);
+                b[1] = (int16_t)((b1i + ui) >> 1);
+                d[0] = (int16_t)((b1r - ur) >> 1);
+                d[1] = (int16_t)((b1i - ui) >> 1);
+            }
+        }
+    }
+}
+
+//Q15原地实数FFT，输出为X/N，排布同adc_fft_real
+void adc_fft_real_q15(const adc_fft_plan_t *plan, int16_t *data) {
+    int half = plan->size / 2;
+    adc_fft_complex_q15(plan, data);
+    int32_t re0 = data[0], im0 = data[1];
+    data[0] = (int16_t)((re0 + im0) >> 1);
+    data[1] = (int16_t)((re0 - im0) >> 1);
+    for (int k = 1; k <= half / 2; k++) {
+        int16_t *zk = data + 2 * k;
+        int16_t *zm = data + 2 * (half - k);
+        int32_t er = (zk[0] + zm[0]) >> 1, ei = (zk[1] - zm[1]) >> 1;
+        int32_t or_ = (zk[1] + zm[1]) >> 1, oi = -((zk[0] - zm[0]) >> 1);
+        int32_t wr = plan->split_q15[2 * k], wi = plan->split_q15[2 * k + 1];
+        int32_t tr = adc_q15_mul(wr, or_) - adc_q15_mul(wi, oi), ti = adc_q15_mul(wr, oi) + adc_q15_mul(wi, or_);
+        zk[0] = (int16_t)((er + tr) >> 1);
+        zk[1] = (int16_t)((ei + ti) >> 1);
+        zm[0] = (int16_t)((er - tr) >> 1);
+        zm[1] = (int16_t)(-((ei - ti) >> 1));
+    }
+}
+
+//由adc_fft_real的输出求N/2+1个频点的|X|^2，第k个频点对应k * fs / N
+void adc_fft_power(const adc_fft_plan_t *plan, const float *spectrum, float *power) {
+    int half = plan->size / 2;
+    power[0] = spectrum[0] * spectrum[0];
+    power[half] = spectrum[1] * spectrum[1];
+    for (int k = 1; k < half; k++) {
+        power[k] = spectrum[2 * k] * spectrum[2 * k] + spectrum[2 * k + 1] * spectrum[2 * k + 1];
+    }
+}
+
+//Welch功率谱密度：N点分段、相邻段重叠overlap点，每段去均值、加Hann窗后做FFT，周期图取平均
+//psd为N/2+1个单边谱密度(单位：采样值^2 / Hz)，返回平均的段数，信号不足一段时返回-1
+int adc_welch_psd(adc_fft_plan_t *plan, const float *signal, int length, int overlap, float sample_rate, float *psd) {
+    int size = plan->size;
+    int half = size / 2;
+    if (overlap < 0 || overlap >= size || length < size || sample_rate <= 0) {
+        return -1;
+    }
+    int hop = size - overlap;
+    int segments = 0;
+    memset(psd, 0, (size_t)(half + 1) * sizeof(float));
+    for (int start = 0; start + size <= length; start += hop) {
+        double mean = 0;
+        for (int i = 0; i < size; i++) {
+            mean += signal[start + i];
+        }
+        mean /= size;
+        for (int i = 0; i < size; i++) {
+            plan->work[i] = (float)(signal[start + i] - mean) * plan->window[i];
+        }
+        adc_fft_real(plan, plan->work);
+        psd[0] += plan->work[0] * plan->work[0];
+        psd[half] += plan->work[1] * plan->work[1];
+        for (int k = 1; k < half; k++) {
+            psd[k] += plan->work[2 * k] * plan->work[2 * k] + plan->work[2 * k + 1] * plan->work[2 * k + 1];
+        }
+        segments++;
+    }
+    //单边谱：除两端点外乘2
+    double scale = 1.0 / (segments * sample_rate * plan->window_power);
+    for (int k = 0; k <= half; k++) {
+        psd[k] = (float)(psd[k] * scale * (k == 0 || k == half ? 1 : 2));
+    }
+    return segments;
+}
+
+//写一个流式Goertzel检测器组，不做整段FFT也能盯住50/60 Hz工频及其谐波、或其他已知频率的干扰
+//每个通道一个adc_goertzel_t，每个采样对每个频点只做一次乘加(s = x + coeff * s1 - s2)，每block个采样结算一次
+//频点不要求落在k * fs / block上；结算时按块均值扣掉直流在该频点上的泄漏(直流响应在init时预先算好)，ADC偏置不会污染结果
+//结算结果：amplitude[i]为该频率正弦分量的幅度估计(ADC码值)，variance为该块的总体方差(与adc_variance_filter同口径，不截断)，
+//amplitude^2 / 2 / variance即该频率干扰占总波动功率的比例，可以直接当作通道的噪声质量指标
+//状态用float，每块开始时以第一个采样为基准扣掉偏置，避免大直流偏置下float精度不够
+#define ADC_GOERTZEL_MAX_BINS 8
+
+typedef struct {
+    int bins;
+    int block;
+    int count;
+    int offset;                            //本块第一个采样
+    int64_t sum;                           //相对offset的和与平方和
+    int64_t sum_squares;
+    float coeff[ADC_GOERTZEL_MAX_BINS];    //2cos(w)
+    float cos_w[ADC_GOERTZEL_MAX_BINS];
+    float sin_w[ADC_GOERTZEL_MAX_BINS];
+    float dc_re[ADC_GOERTZEL_MAX_BINS];    //全1输入的结算值
+    float dc_im[ADC_GOERTZEL_MAX_BINS];
+    float s1[ADC_GOERTZEL_MAX_BINS];
+    float s2[ADC_GOERTZEL_MAX_BINS];
+    float amplitude[ADC_GOERTZEL_MAX_BINS];
+    float variance;
+    int64_t blocks;                        //已结算的块数
+} adc_goertzel_t;
+
+int adc_goertzel_init(adc_goertzel_t *g, float sample_rate, const float *frequencies, int bins, int block) {
+    if (bins < 1 || bins > ADC_GOERTZEL_MAX_BINS || block < 2 || sample_rate <= 0) {
+        return -1;
+    }
+    memset(g, 0, sizeof(*g));
+    g->bins = bins;
+    g->block = block;
+    for (int i = 0; i < bins; i++) {
+        if (frequencies[i] < 0 || frequencies[i] > sample_rate / 2) {
+            return -1;
+        }
+        double w = 2 * ADC_PI * frequencies[i] / sample_rate;
+        g->coeff[i] = (float)(2 * cos(w));
+        g->cos_w[i] = (float)cos(w);
+        g->sin_w[i] = (float)sin(w);
+        float s1 = 0, s2 = 0;
+        for (int n = 0; n < block; n++) {
+            float s = 1.0f + g->coeff[i] * s1 - s2;
+            s2 = s1;
+            s1 = s;
+        }
+        g->dc_re[i] = s1 - g->cos_w[i] * s2;
+        g->dc_im[i] = g->sin_w[i] * s2;
+    }
+    return 0;
+}
+
+//推入一个采样，一块结束时结算并返回1，否则返回0
+int adc_goertzel_push(adc_goertzel_t *g, int sample) {
+    if (g->count == 0) {
+        g->offset = sample;
+    }
+    int64_t x = (int64_t)sample - g->offset;
+    g->sum += x;
+    g->sum_squares += x * x;
+    for (int i = 0; i < g->bins; i++) {
+        float s = (float)x + g->coeff[i] * g->s1[i] - g->s2[i];
+        g->s2[i] = g->s1[i];
+        g->s1[i] = s;
+    }
+    if (++g->count < g->block) {
+        return 0;
+    }
+    double mean = (double)g->sum / g->block;
+    for (int i = 0; i < g->bins; i++) {
+        double re = g->s1[i] - g->cos_w[i] * g->s2[i] - mean * g->dc_re[i];
+        double im = g->sin_w[i] * g->s2[i] - mean * g->dc_im[i];
+        g->amplitude[i] = (float)(2 * sqrt(re * re + im * im) / g->block);
+        g->s1[i] = 0;
+        g->s2[i] = 0;
+    }
+    g->variance = (float)((double)g->sum_squares / g->block - mean * mean);
+    g->sum = 0;
+    g->sum_squares = 0;
+    g->count = 0;
+    g->blocks++;
+    return 1;
+}
+
+//推入一段采样，返回其中结算的块数；amplitude和variance保存最近一块的结果
+int adc_goertzel_process(adc_goertzel_t *g, const int *values, int length) {
+    int reported = 0;
+    for (int i = 0; i < length; i++) {
+        reported += adc_goertzel_push(g, values[i]);
+    }
+    return reported;
+}
+
+//第bin个频点的干扰功率占本块方差的比例，方差为0时返回0
+float adc_goertzel_power_ratio(const adc_goertzel_t *g, int bin) {
+    if (g->variance <= 0) {
+        return 0;
+    }
+    return g->amplitude[bin] * g->amplitude[bin] / 2 / g->variance;
+}
+
+//写一个基于自相关的心率估计，运动干扰下比adaptive_threshold_algorithm的过阈值计数稳
+//在最近window个采样的滑动窗口上，对40~220 BPM对应的滞后范围计算归一化自相关，取最可信的峰值换算成BPM
+//增量更新：每来一个采样，每个滞后只加上新进入的一对乘积、减去离开窗口的一对，不重算整个窗口(每采样O(滞后数))；
+//积和与采样前缀和都用uint64_t模2^64累加，加减完全抵消、长时间运行不漂移，差值只要小于2^63就是精确的
+//去直流在估计时做：用前缀和得到各段的和与平方和，按窗口均值把乘积和与能量修正为中心化的值，输入可以直接是带直流的PPG原始值
+//估计adc_hr_estimate为O(滞后数)，100 Hz采样、窗口4 s时约150个滞后，25 Hz的更新频率在小核上负担很小
+#define ADC_HR_MAX_WINDOW 512
+#define ADC_HR_MAX_LAGS 256
+#define ADC_HR_MIN_BPM 40
+#define ADC_HR_MAX_BPM 220
+
+typedef struct {
+    float sample_rate;
+    int window;
+    int lag_low;                                 //跟踪的滞后范围，比生理范围两端各多1，用于峰值插值
+    int lag_high;
+    int64_t count;                               //已推入的采样数
+    int32_t samples[ADC_HR_MAX_WINDOW + 1];      //环形，下标count % (window + 1)
+    uint64_t prefix[ADC_HR_MAX_WINDOW + 1];      //采样的累计和，同样环形
+    uint64_t prefix_squares[ADC_HR_MAX_WINDOW + 1];
+    uint64_t products[ADC_HR_MAX_LAGS];          //窗口内x[n] * x[n - lag]之和，下标lag - lag_low
+    float correlation[ADC_HR_MAX_LAGS];          //最近一次估计的归一化自相关
+} adc_hr_estimator_t;
+
+//window为窗口采样数，至少要容纳两个最长心跳周期(40 BPM)
+int adc_hr_init(adc_hr_estimator_t *hr, float sample_rate, int window) {
+    if (sample_rate <= 0) {
+        return -1;
+    }
+    int lag_low = (int)(60.0f * sample_rate / ADC_HR_MAX_BPM) - 1;
+    int lag_high = (int)ceilf(60.0f * sample_rate / ADC_HR_MIN_BPM) + 1;
+    if (lag_low < 1 || lag_high - lag_low + 1 > ADC_HR_MAX_LAGS || window < 2 * lag_high || window > ADC_HR_MAX_WINDOW) {
+        return -1;
+    }
+    memset(hr, 0, sizeof(*hr));
+    hr->sample_rate = sample_rate;
+    hr->window = window;
+    hr->lag_low = lag_low;
+    hr->lag_high = lag_high;
+    return 0;
+}
+
+static int32_t adc_hr_sample(const adc_hr_estimator_t *hr, int64_t t) {
+    return hr->samples[t % (hr->window + 1)];
+}
+
+void adc_hr_push(adc_hr_estimator_t *hr, int sample) {
+    int64_t t = hr->count;
+    int capacity = hr->window + 1;
+    int slot = (int)(t % capacity);
+    uint64_t previous = t > 0 ? hr->prefix[(slot + capacity - 1) % capacity] : 0;
+    uint64_t previous_squares = t > 0 ? hr->prefix_squares[(slot + capacity - 1) % capacity] : 0;
+    //slot里原来是t - window - 1的采样，已经在窗口外，先读出t - window再覆盖
+    int64_t leaving_index = t - hr->window;
+    int32_t leaving = leaving_index >= 0 ? adc_hr_sample(hr, leaving_index) : 0;
+    hr->samples[slot] = sample;
+    hr->prefix[slot] = previous + (uint64_t)(int64_t)sample;
+    hr->prefix_squares[slot] = previous_squares + (uint64_t)((int64_t)sample * sample);
+    for (int lag = hr->lag_low; lag <= hr->lag_high; lag++) {
+        uint64_t delta = 0;
+        if (t - lag >= 0) {
+            delta += (uint64_t)((int64_t)sample * adc_hr_sample(hr, t - lag));
+        }
+        if (leaving_index >= 0) {
+            delta -= (uint64_t)((int64_t)leaving * adc_hr_sample(hr, leaving_index + lag));
+        }
+        hr->products[lag - hr->lag_low] += delta;
+    }
+    hr->count++;
+}
+
+void adc_hr_process(adc_hr_estimator_t *hr, const int *values, int length) {
+    for (int i = 0; i < length; i++) {
+        adc_hr_push(hr, values[i]);
+    }
+}
+
+//采样下标[first, last]上的和(模2^64差分后按有符号解释)
+static double adc_hr_range(const uint64_t *prefix, const adc_hr_estimator_t *hr, int64_t first, int64_t last) {
+    int capacity = hr->window + 1;
+    return (double)(int64_t)(prefix[last % capacity] - prefix[(first - 1) % capacity]);
+}
+
+//过r[lag - 1]、r[lag]、r[lag + 1]的抛物线顶点相对lag的偏移(-0.5~0.5)和高度
+static float adc_hr_peak_offset(const float *r, int lag) {
+    float curvature = r[lag - 1] - 2 * r[lag] + r[lag + 1];
+    return curvature < 0 ? 0.5f * (r[lag - 1] - r[lag + 1]) / curvature : 0.0f;
+}
+
+static float adc_hr_peak_height(const float *r, int lag) {
+    return r[lag] - 0.25f * (r[lag - 1] - r[lag + 1]) * adc_hr_peak_offset(r, lag);
+}
+
+//估计心率：bpm为每分钟心跳数，quality为峰值处的归一化自相关(0~1，越接近1周期性越好)
+//窗口未满、信号是常数或找不到正的自相关峰时返回-1
+int adc_hr_estimate(adc_hr_estimator_t *hr, float *bpm, float *quality) {
+    if (hr->count <= hr->window) {
+        return -1;
+    }
+    int64_t last = hr->count - 1;
+    int64_t first = last - hr->window + 1;
+    double mean = adc_hr_range(hr->prefix, hr, first, last) / hr->window;
+    for (int lag = hr->lag_low; lag <= hr->lag_high; lag++) {
+        double n = hr->window - lag;
+        double head = adc_hr_range(hr->prefix, hr, first, last - lag);
+        double tail = adc_hr_range(hr->prefix, hr, first + lag, last);
+        double head_energy = adc_hr_range(hr->prefix_squares, hr, first, last - lag) - 2 * mean * head + n * mean * mean;
+        double tail_energy = adc_hr_range(hr->prefix_squares, hr, first + lag, last) - 2 * mean * tail + n * mean * mean;
+        double product = (double)(int64_t)hr->products[lag - hr->lag_low] - mean * (head + tail) + n * mean * mean;
+        double energy = head_energy * tail_energy;
+        hr->correlation[lag - hr->lag_low] = energy > 0 ? (float)(product / sqrt(energy)) : 0.0f;
+    }
+    //找生理范围内的局部极大值，峰高和位置都用抛物线插值(低采样率时周期常落在两个整数滞后之间)；
+    //周期为P时2P处也有峰，取不低于最高峰85%的最短滞后，避免报成半速率
+    const float *r = hr->correlation - hr->lag_low;
+    float best = 0;
+    for (int lag = hr->lag_low + 1; lag < hr->lag_high; lag++) {
+        if (r[lag] > r[lag - 1] && r[lag] >= r[lag + 1] && adc_hr_peak_height(r, lag) > best) {
+            best = adc_hr_peak_height(r, lag);
+        }
+    }
+    if (best <= 0) {
+        return -1;
+    }
+    int peak = 0;
+    for (int lag = hr->lag_low + 1; lag < hr->lag_high; lag++) {
+        if (r[lag] > r[lag - 1] && r[lag] >= r[lag + 1] && adc_hr_peak_height(r, lag) >= 0.85f * best) {
+            peak = lag;
+            break;
+        }
+    }
+    float offset = adc_hr_peak_offset(r, peak);
+    float height = adc_hr_peak_height(r, peak);
+    *bpm = 60.0f * hr->sample_rate / ((float)peak + offset);
+    *quality = height > 1.0f ? 1.0f : height;
+    return 0;
+}
+
+//写一个MAX30102的FIFO突发读取解码器，替代各处手写的逐采样移位、掩码代码
+//FIFO深32个采样，每个采样按时隙(SpO2模式为红光、红外两个时隙，多LED模式最多4个)依次排列，每个时隙3字节大端，有效18位
+//固件读法：先读FIFO_WR_PTR、OVF_COUNTER、FIFO_RD_PTR，用max30102_fifo_available算出可读采样数，
+//再从FIFO_DATA一次突发读出 可读数 * 时隙数 * 3 字节，交给max30102_decode_burst一遍解进各LED的环形缓冲区
+//读指针在芯片内部自动回绕，突发字节流本身是连续的；写、读指针相等时OVF_COUNTER非0表示FIFO满(32个)，
+//OVF_COUNTER即被覆盖丢弃的采样数(芯片上饱和于31)，累计在dropped里供上层判断数据是否连续
+//环形缓冲区存int，max30102_ring_latest把最新n个采样拷成连续数组，可以直接交给adaptive_threshold_algorithm
+//主机端回放录制的大段字节流用max30102_unpack，3字节转换走adc_kernels的SIMD实现
+#define MAX30102_FIFO_DEPTH 32
+#define MAX30102_MAX_SLOTS 4
+#define MAX30102_SAMPLE_MASK 0x3FFFF
+#define MAX30102_UNPACK_CHUNK 256
+
+typedef struct {
+    int *data;
+    int capacity;
+    int head;       //下一个写入位置
+    int count;
+} max30102_ring_t;
+
+typedef struct {
+    int slots;
+    max30102_ring_t rings[MAX30102_MAX_SLOTS];  //下标即时隙，SpO2模式下0为红光、1为红外
+    int64_t samples;                            //已解码的采样数(每个时隙各算一次)
+    int64_t dropped;                            //因FIFO溢出丢失的采样数
+} max30102_decoder_t;
+
+//slots个时隙，storage[i]为时隙i的环形缓冲区，每个capacity个int
+int max30102_decoder_init(max30102_decoder_t *decoder, int slots, int *const *storage, int capacity) {
+    if (slots < 1 || slots > MAX30102_MAX_SLOTS || capacity < 1) {
+        return -1;
+    }
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->slots = slots;
+    for (int i = 0; i < slots; i++) {
+        decoder->rings[i].data = storage[i];
+        decoder->rings[i].capacity = capacity;
+    }
+    return 0;
+}
+
+//由寄存器值算FIFO里可读的采样数，指针为5位
+int max30102_fifo_available(uint8_t write_ptr, uint8_t read_ptr, uint8_t overflow) {
+    int available = (write_ptr - read_ptr) & (MAX30102_FIFO_DEPTH - 1);
+    if (available == 0 && (overflow & 0x1F) != 0) {
+        available = MAX30102_FIFO_DEPTH;
+    }
+    return available;
+}
+
+//解一次突发读出的count个采样(count * slots * 3字节)，overflow为读取前的OVF_COUNTER；返回解出的采样数
+int max30102_decode_burst(max30102_decoder_t *decoder, const uint8_t *burst, int count, uint8_t overflow) {
+    if (count < 0 || count > MAX30102_FIFO_DEPTH) {
+        return -1;
+    }
+    for (int n = 0; n < count; n++) {
+        for (int slot = 0; slot < decoder->slots; slot++) {
+            const uint8_t *word = burst + 3 * (n * decoder->slots + slot);
+            max30102_ring_t *ring = &decoder->rings[slot];
+            ring->data[ring->head] = (((int)word[0] << 16) | ((int)word[1] << 8) | word[2]) & MAX30102_SAMPLE_MASK;
+            ring->head = ring->head + 1 == ring->capacity ? 0 : ring->head + 1;
+            if (ring->count < ring->capacity) {
+                ring->count++;
+            }
+        }
+    }
+    decoder->samples += (int64_t)count * decoder->slots;
+    decoder->dropped += (int64_t)(overflow & 0x1F) * decoder->slots;
+    return count;
+}
+
+//把环形缓冲区里最新的n个采样按时间顺序拷到output，返回实际拷贝数(不超过已有采样数)
+int max30102_ring_latest(const max30102_ring_t *ring, int *output, int n) {
+    if (n > ring->count) {
+        n = ring->count;
+    }
+    int start = ring->head - n;
+    if (start < 0) {
+        int wrapped = -start;
+        memcpy(output, ring->data + ring->capacity - wrapped, (size_t)wrapped * sizeof(int));
+        memcpy(output + wrapped, ring->data, (size_t)(n - wrapped) * sizeof(int));
+    } else {
+        memcpy(output, ring->data + start, (size_t)n * sizeof(int));
+    }
+    return n;
+}
+
+//主机端：把录制的连续FIFO字节流(samples个采样、slots个时隙交织)解成每个时隙一个数组，outputs[i]需要samples个int
+//按块先用SIMD把3字节字转成int，再在缓存里拆分时隙
+void max30102_unpack(const uint8_t *bytes, int samples, int slots, int *const *outputs) {
+    int words[MAX30102_UNPACK_CHUNK * MAX30102_MAX_SLOTS];
+    for (int start = 0; start < samples; start += MAX30102_UNPACK_CHUNK) {
+        int count = samples - start < MAX30102_UNPACK_CHUNK ? samples - start : MAX30102_UNPACK_CHUNK;
+        adc_kernels->unpack_be24(bytes + (size_t)3 * start * slots, words, count * slots, MAX30102_SAMPLE_MASK);
+        if (slots == 1) {
+            memcpy(outputs[0] + start, words, (size_t)count * sizeof(int));
+            continue;
+        }
+        for (int slot = 0; slot < slots; slot++) {
+            int *output = outputs[slot] + start;
+            for (int n = 0; n < count; n++) {
+                output[n] = words[n * slots + slot];
+            }
+        }
+    }
+}
+
+//写一个增量的心率变异性(HRV)统计：RMSSD、SDNN、pNN50，输入为adaptive_threshold_algorithm阈值检出的心跳时间戳或心跳间期(ms)
+//滚动窗口保存在有界环形缓冲区里(最多capacity个间期，可再按总时长window_ms截断)，
+//每进一个间期只更新几个整数累加量：间期和、平方和、相邻差平方和、|差|>50 ms的个数，进、出窗口各O(1)，指标随时可读
+//全部用整数累加，增删完全抵消，长时间运行不漂移
+//异位搏动剔除：间期超出300~2000 ms、或与窗口均值相差超过20%时丢弃；丢弃后下一个间期不与之前的间期求相邻差，
+//连续丢弃ADC_HRV_MAX_REJECTS个后认为心率真的变了，清空窗口重新开始
+#define ADC_HRV_MAX_INTERVALS 512
+#define ADC_HRV_MIN_INTERVAL_MS 300
+#define ADC_HRV_MAX_INTERVAL_MS 2000
+#define ADC_HRV_ECTOPIC_PERCENT 20
+#define ADC_HRV_MAX_REJECTS 5
+
+typedef struct {
+    int capacity;
+    int window_ms;                                 //0表示只按个数限制
+    int head;                                      //最旧间期的位置
+    int count;
+    int intervals[ADC_HRV_MAX_INTERVALS];
+    int differences[ADC_HRV_MAX_INTERVALS];        //与前一个间期的差，前一个不连续时无效
+    uint8_t successive[ADC_HRV_MAX_INTERVALS];     //differences是否有效
+    int64_t sum;
+    int64_t sum_squares;
+    int64_t difference_squares;
+    int difference_count;
+    int nn50;
+    int linked;                                    //下一个间期能否与窗口里最新的间期求相邻差
+    int has_beat;
+    uint32_t last_beat_ms;
+    int reject_run;
+    int64_t accepted;
+    int64_t rejected;
+} adc_hrv_t;
+
+int adc_hrv_init(adc_hrv_t *hrv, int capacity, int window_ms) {
+    if (capacity < 2 || capacity > ADC_HRV_MAX_INTERVALS || window_ms < 0) {
+        return -1;
+    }
+    memset(hrv, 0, sizeof(*hrv));
+    hrv->capacity = capacity;
+    hrv->window_ms = window_ms;
+    return 0;
+}
+
+//移出最旧的间期；新的最旧间期的相邻差引用了被移出的间期，一并移出
+static void adc_hrv_evict(adc_hrv_t *hrv) {
+    int oldest = hrv->intervals[hrv->head];
+    hrv->sum -= oldest;
+    hrv->sum_squares -= (int64_t)oldest * oldest;
+    hrv->head = hrv->head + 1 == hrv->capacity ? 0 : hrv->head + 1;
+    hrv->count--;
+    if (hrv->count > 0 && hrv->successive[hrv->head]) {
+        int difference = hrv->differences[hrv->head];
+        hrv->difference_squares -= (int64_t)difference * difference;
+        hrv->difference_count--;
+        hrv->nn50 -= abs(difference) > 50;
+        hrv->successive[hrv->head] = 0;
+    }
+}
+
+static void adc_hrv_clear(adc_hrv_t *hrv) {
+    while (hrv->count > 0) {
+        adc_hrv_evict(hrv);
+    }
+    hrv->linked = 0;
+}
+
+//推入一个心跳间期(ms)，返回1表示接受，0表示作为异位搏动或伪迹丢弃
+int adc_hrv_push_interval(adc_hrv_t *hrv, int interval_ms) {
+    int plausible = interval_ms >= ADC_HRV_MIN_INTERVAL_MS && interval_ms <= ADC_HRV_MAX_INTERVAL_MS;
+    int ectopic = hrv->count > 0 &&
+                  llabs((int64_t)interval_ms * hrv->count - hrv->sum) * 100 > (int64_t)ADC_HRV_ECTOPIC_PERCENT * hrv->sum;
+    if (!plausible || ectopic) {
+        hrv->rejected++;
+        hrv->linked = 0;
+        if (plausible && ++hrv->reject_run >= ADC_HRV_MAX_REJECTS) {
+            adc_hrv_clear(hrv);
+            hrv->reject_run = 0;
+        }
+        return 0;
+    }
+    hrv->reject_run = 0;
+    if (hrv->count == hrv->capacity) {
+        adc_hrv_evict(hrv);
+    }
+    int slot = hrv->head + hrv->count;
+    if (slot >= hrv->capacity) {
+        slot -= hrv->capacity;
+    }
+    hrv->successive[slot] = 0;
+    if (hrv->linked && hrv->count > 0) {
+        int previous = hrv->intervals[slot == 0 ? hrv->capacity - 1 : slot - 1];
+        int difference = interval_ms - previous;
+        hrv->differences[slot] = difference;
+        hrv->successive[slot] = 1;
+        hrv->difference_squares += (int64_t)difference * difference;
+        hrv->difference_count++;
+        hrv->nn50 += abs(difference) > 50;
+    }
+    hrv->intervals[slot] = interval_ms;
+    hrv->count++;
+    hrv->sum += interval_ms;
+    hrv->sum_squares += (int64_t)interval_ms * interval_ms;
+    hrv->linked = 1;
+    hrv->accepted++;
+    while (hrv->window_ms > 0 && hrv->count > 1 && hrv->sum > hrv->window_ms) {
+        adc_hrv_evict(hrv);
+    }
+    return 1;
+}
+
+//推入一个心跳时间戳(ms，允许32位回绕)，第一个心跳只记录时间；返回值同adc_hrv_push_interval，第一个心跳返回0
+int adc_hrv_push_beat(adc_hrv_t *hrv, uint32_t timestamp_ms) {
+    int first = !hrv->has_beat;
+    uint32_t interval = timestamp_ms - hrv->last_beat_ms;
+    hrv->has_beat = 1;
+    hrv->last_beat_ms = timestamp_ms;
+    if (first) {
+        return 0;
+    }
+    return adc_hrv_push_interval(hrv, interval > INT32_MAX ? INT32_MAX : (int)interval);
+}
+
+//相邻间期差的均方根(ms)，没有有效相邻差时返回0
+float adc_hrv_rmssd(const adc_hrv_t *hrv) {
+    if (hrv->difference_count == 0) {
+        return 0;
+    }
+    return (float)sqrt((double)hrv->difference_squares / hrv->difference_count);
+}
+
+//窗口内间期的标准差(ms)，按样本标准差(n - 1)计算
+float adc_hrv_sdnn(const adc_hrv_t *hrv) {
+    if (hrv->count < 2) {
+        return 0;
+    }
+    double n = hrv->count;
+    double variance = ((double)hrv->sum_squares - (double)hrv->sum * hrv->sum / n) / (n - 1);
+    return variance > 0 ? (float)sqrt(variance) : 0.0f;
+}
+
+//相邻差超过50 ms的比例(百分数)
+float adc_hrv_pnn50(const adc_hrv_t *hrv) {
+    if (hrv->difference_count == 0) {
+        return 0;
+    }
+    return 100.0f * hrv->nn50 / hrv->difference_count;
+}
+
+//窗口内平均心率(BPM)
+float adc_hrv_mean_bpm(const adc_hrv_t *hrv) {
+    if (hrv->count == 0) {
+        return 0;
+    }
+    return (float)(60000.0 * hrv->count / hrv->sum);
+}
+
+//写一个定点NLMS自适应噪声抵消器，用同一腕带上加速度计的合加速度做参考，在adaptive_threshold_algorithm阈值检测之前去掉与运动相关的PPG分量
+//参考信号r = |a| - 直流(去掉重力)，PPG同样先去直流；滤波器用最近taps个r估计PPG里的运动分量y，误差e = PPG交流 - y，
+//输出 = 原始PPG - y(保留直流，后面的阈值、SpO2计算照常使用)，权值按 w += mu * e * r / (||r||^2 + eps) 更新
+//全定点：权值Q16(可表示±32768倍的增益)，步长mu为Q15，||r||^2随采样增量维护，每个采样只做一次64位除法，其余为乘加
+//参考历史用双写环形缓存，窗口总是连续的；taps和mu在init时给定，状态全部在结构体里，不分配内存
+//去直流的截止频率要远低于运动频率：输出里减掉的是高通后的估计，截止附近的运动分量会漏过去
+#define ADC_NLMS_MAX_TAPS 64
+#define ADC_NLMS_WEIGHT_BITS 16
+#define ADC_NLMS_DC_SHIFT 8         //去直流的一阶IIR：dc += (x - dc) / 256，100 Hz采样时截止约0.06 Hz
+#define ADC_NLMS_MIN_POWER 16       //eps = taps * 16，参考信号均方根低于4个码值时几乎不更新
+
+typedef struct {
+    int taps;
+    int step_q15;
+    int pos;
+    int primed;                            //直流估计是否已用第一个采样初始化
+    int32_t ppg_dc;                        //Q8
+    int32_t reference_dc;                  //Q8
+    int64_t power;                         //窗口内r的平方和
+    int32_t weights[ADC_NLMS_MAX_TAPS];    //Q16，weights[k]对应窗口里第k个(从旧到新)参考采样
+    int16_t history[2 * ADC_NLMS_MAX_TAPS];
+} adc_nlms_t;
+
+//step为NLMS步长(0~1)，常用0.01~0.1：越大收敛越快、稳态失调也越大
+int adc_nlms_init(adc_nlms_t *nlms, int taps, float step) {
+    if (taps < 1 || taps > ADC_NLMS_MAX_TAPS || step <= 0 || step >= 1) {
+        return -1;
+    }
+    memset(nlms, 0, sizeof(*nlms));
+    nlms->taps = taps;
+    nlms->step_q15 = (int)lrintf(step * 32768);
+    return 0;
+}
+
+//64位整数平方根(向下取整)，加速度计合成时不依赖浮点
+static uint32_t adc_isqrt64(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+int adc_accel_magnitude(int ax, int ay, int az) {
+    return (int)adc_isqrt64((uint64_t)((int64_t)ax * ax) + (uint64_t)((int64_t)ay * ay) + (uint64_t)((int64_t)az * az));
+}
+
+//处理一个采样：ppg为原始PPG，reference为运动参考(通常是adc_accel_magnitude)，返回去掉运动分量后的PPG
+int adc_nlms_process(adc_nlms_t *nlms, int ppg, int reference) {
+    if (!nlms->primed) {
+        nlms->ppg_dc = ppg * 256;
+        nlms->reference_dc = reference * 256;
+        nlms->primed = 1;
+    }
+    nlms->ppg_dc += (ppg * 256 - nlms->ppg_dc) >> ADC_NLMS_DC_SHIFT;
+    nlms->reference_dc += (reference * 256 - nlms->reference_dc) >> ADC_NLMS_DC_SHIFT;
+    int32_t r = reference - (nlms->reference_dc >> 8);
+    r = r > INT16_MAX ? INT16_MAX : r < -INT16_MAX ? -INT16_MAX : r;
+    int taps = nlms->taps;
+    int16_t leaving = nlms->history[nlms->pos];
+    nlms->history[nlms->pos] = (int16_t)r;
+    nlms->history[nlms->pos + taps] = (int16_t)r;
+    nlms->pos = nlms->pos + 1 == taps ? 0 : nlms->pos + 1;
+    nlms->power += (int64_t)r * r - (int64_t)leaving * leaving;
+    const int16_t *window = nlms->history + nlms->pos;
+    int64_t estimate = 0;
+    for (int k = 0; k < taps; k++) {
+        estimate += (int64_t)nlms->weights[k] * window[k];
+    }
+    estimate >>= ADC_NLMS_WEIGHT_BITS;
+    int64_t error = (int64_t)ppg - (nlms->ppg_dc >> 8) - estimate;
+    //gain = mu * e / (||r||^2 + eps)，多保留16位小数；w_k += gain * r_k，gain * r_k不超过2^48
+    int64_t gain = ((int64_t)nlms->step_q15 * error * 65536) / (nlms->power + (int64_t)taps * ADC_NLMS_MIN_POWER);
+    for (int k = 0; k < taps; k++) {
+        int64_t weight = nlms->weights[k] + ((gain * window[k]) >> (15 + 16 - ADC_NLMS_WEIGHT_BITS));
+        nlms->weights[k] = (int32_t)(weight > INT32_MAX ? INT32_MAX : weight < -INT32_MAX ? -INT32_MAX : weight);
+    }
+    return (int)(ppg - estimate);
+}
+
+//按块处理：ppg和三轴加速度逐采样对应，output可以等于ppg
+void adc_nlms_process_block(adc_nlms_t *nlms, const int *ppg, const int *ax, const int *ay, const int *az, int *output, int length) {
+    for (int i = 0; i < length; i++) {
+        output[i] = adc_nlms_process(nlms, ppg[i], adc_accel_magnitude(ax[i], ay[i], az[i]));
+    }
+}
+
+//写一个PPG信号质量指数(SQI)，手指离开MAX30102或信号是噪声时，直接跳过心率/SpO2这些重计算，设备放在桌上空转时省电省CPU
+//每个采样只做几次加法和比较(与adaptive_threshold_algorithm用的均值一起累加)，每block个采样结算一次：
+//  直流：块均值(与adc_mean_filter同样截断)，要落在[dc_min, dc_max]，太低是没有手指、太高是饱和
+//  灌注指数：峰峰值 / 直流 * 100%，太小是没有脉搏、太大是运动或漏光
+//  过零规律性：以时间常数约1 s的滑动基线为电平检测过零，上升沿要越过基线到峰值包络的一半、回落到基线以下才重新计数，
+//            重搏波通常到不了一半，不会被重复计数；
+//            相邻上升沿间隔的变异系数(标准差/均值)要小，对应的速率要在40~220 BPM；间隔超过2 s时重新起算
+//  峰度：超额峰度，脉搏波形一般在-1.8~5之间，尖刺和突跳会让它变得很大
+//四项都通过时该块可用；门控带迟滞：连续ADC_SQI_OPEN_BLOCKS块可用才打开，连续ADC_SQI_CLOSE_BLOCKS块不可用才关闭，避免来回抖动
+//阈值在init里取默认值(18位MAX30102)，调用者可以在init之后直接改结构体里的字段
+#define ADC_SQI_OPEN_BLOCKS 2
+#define ADC_SQI_CLOSE_BLOCKS 2
+#define ADC_SQI_FAIL_DC 1
+#define ADC_SQI_FAIL_PERFUSION 2
+#define ADC_SQI_FAIL_REGULARITY 4
+#define ADC_SQI_FAIL_KURTOSIS 8
+
+typedef struct {
+    int dc;                     //块均值
+    float perfusion_index;      //百分数
+    float rate_bpm;             //由上升沿间隔估计的速率，上升沿不足时为0
+    float crossing_cv;          //上升沿间隔的变异系数，上升沿不足时为-1
+    float kurtosis;             //超额峰度
+    int failures;               //ADC_SQI_FAIL_*的组合
+    float score;                //通过的项数 / 4
+} adc_ppg_quality_t;
+
+typedef struct {
+    float sample_rate;
+    int block;
+    //阈值
+    int dc_min;
+    int dc_max;
+    float perfusion_min;
+    float perfusion_max;
+    float cv_max;
+    float kurtosis_min;
+    float kurtosis_max;
+    //本块累加量
+    int count;
+    int offset;                 //本块第一个采样，矩以它为原点累加，避免大直流下double丢精度
+    int64_t sum;
+    double moments[3];          //(x - offset)的2、3、4次方和
+    int minimum;
+    int maximum;
+    //过零检测，跨块保持
+    int baseline_shift;         //基线和偏差的一阶IIR系数为2^-shift，2^shift约为1 s的采样数
+    int32_t baseline;           //Q8
+    int32_t envelope;           //Q8，峰值包络：超过时跟上，否则以约2 s的时间常数向基线回落
+    int above;
+    int64_t position;
+    int64_t last_rise;
+    int rises;
+    int64_t interval_sum;
+    int64_t interval_squares;
+    //结果与门控
+    adc_ppg_quality_t quality;
+    int good_run;
+    int bad_run;
+    int open;
+} adc_ppg_sqi_t;
+
+//block为结算间隔(采样数)，要能容纳几个心跳周期，例如100 Hz下取300~500
+int adc_ppg_sqi_init(adc_ppg_sqi_t *sqi, float sample_rate, int block) {
+    if (sample_rate <= 0 || block < 4) {
+        return -1;
+    }
+    memset(sqi, 0, sizeof(*sqi));
+    sqi->sample_rate = sample_rate;
+    sqi->block = block;
+    sqi->dc_min = 10000;
+    sqi->dc_max = 250000;
+    sqi->perfusion_min = 0.05f;
+    sqi->perfusion_max = 20.0f;
+    sqi->cv_max = 0.3f;
+    sqi->kurtosis_min = -1.8f;
+    sqi->kurtosis_max = 5.0f;
+    sqi->last_rise = -1;
+    sqi->quality.crossing_cv = -1;
+    while (sqi->baseline_shift < 12 && (1 << (sqi->baseline_shift + 1)) <= sample_rate * 1.5f) {
+        sqi->baseline_shift++;
+    }
+    return 0;
+}
+
+static void adc_ppg_sqi_settle(adc_ppg_sqi_t *sqi) {
+    adc_ppg_quality_t *q = &sqi->quality;
+    double n = sqi->block;
+    q->dc = (int)(sqi->sum / sqi->block);
+    //offset为原点的一阶矩(精确整数)换成中心矩
+    double m1 = (double)(sqi->sum - (int64_t)sqi->offset * sqi->block) / n;
+    double m2 = sqi->moments[0] / n;
+    double m3 = sqi->moments[1] / n;
+    double m4 = sqi->moments[2] / n;
+    double variance = m2 - m1 * m1;
+    double central4 = m4 - 4 * m1 * m3 + 6 * m1 * m1 * m2 - 3 * m1 * m1 * m1 * m1;
+    q->kurtosis = variance > 0 ? (float)(central4 / (variance * variance) - 3) : 0.0f;
+    q->perfusion_index = q->dc > 0 ? 100.0f * (float)(sqi->maximum - sqi->minimum) / (float)q->dc : 0.0f;
+    q->rate_bpm = 0;
+    q->crossing_cv = -1;
+    int intervals = sqi->rises - 1;
+    if (intervals >= 2) {
+        double mean = (double)sqi->interval_sum / intervals;
+        double spread = (double)sqi->interval_squares / intervals - mean * mean;
+        q->rate_bpm = (float)(60.0 * sqi->sample_rate / mean);
+        q->crossing_cv = (float)(spread > 0 ? sqrt(spread) / mean : 0);
+    }
+    q->failures = 0;
+    if (q->dc < sqi->dc_min || q->dc > sqi->dc_max) {
+        q->failures |= ADC_SQI_FAIL_DC;
+    }
+    if (q->perfusion_index < sqi->perfusion_min || q->perfusion_index > sqi->perfusion_max) {
+        q->failures |= ADC_SQI_FAIL_PERFUSION;
+    }
+    if (q->crossing_cv < 0 || q->crossing_cv > sqi->cv_max || q->rate_bpm < ADC_HR_MIN_BPM || q->rate_bpm > ADC_HR_MAX_BPM) {
+        q->failures |= ADC_SQI_FAIL_REGULARITY;
+    }
+    if (variance <= 0 || q->kurtosis < sqi->kurtosis_min || q->kurtosis > sqi->kurtosis_max) {
+        q->failures |= ADC_SQI_FAIL_KURTOSIS;
+    }
+    int passed = 4;
+    for (int bit = ADC_SQI_FAIL_DC; bit <= ADC_SQI_FAIL_KURTOSIS; bit <<= 1) {
+        passed -= (q->failures & bit) != 0;
+    }
+    q->score = passed / 4.0f;
+    if (q->failures == 0) {
+        sqi->bad_run = 0;
+        if (++sqi->good_run >= ADC_SQI_OPEN_BLOCKS) {
+            sqi->open = 1;
+        }
+    } else {
+        sqi->good_run = 0;
+        if (++sqi->bad_run >= ADC_SQI_CLOSE_BLOCKS) {
+            sqi->open = 0;
+        }
+    }
+}
+
+//推入一个采样，一块结束时结算并返回1，否则返回0
+int adc_ppg_sqi_push(adc_ppg_sqi_t *sqi, int sample) {
+    if (sqi->count == 0) {
+        if (sqi->position == 0) {
+            sqi->baseline = sample * 256;
+            sqi->envelope = sample * 256;
+        }
+        sqi->offset = sample;
+        sqi->sum = 0;
+        sqi->moments[0] = sqi->moments[1] = sqi->moments[2] = 0;
+        sqi->minimum = sample;
+        sqi->maximum = sample;
+        sqi->rises = sqi->last_rise >= 0 ? 1 : 0;
+        sqi->interval_sum = 0;
+        sqi->interval_squares = 0;
+    }
+    sqi->sum += sample;
+    double x = (double)(sample - sqi->offset);
+    double x2 = x * x;
+    sqi->moments[0] += x2;
+    sqi->moments[1] += x2 * x;
+    sqi->moments[2] += x2 * x2;
+    sqi->minimum = sample < sqi->minimum ? sample : sqi->minimum;
+    sqi->maximum = sample > sqi->maximum ? sample : sqi->maximum;
+    sqi->baseline += (sample * 256 - sqi->baseline) >> sqi->baseline_shift;
+    if (sample * 256 > sqi->envelope) {
+        sqi->envelope = sample * 256;
+    } else {
+        sqi->envelope -= (sqi->envelope - sqi->baseline) >> (sqi->baseline_shift + 1);
+    }
+    int level = sqi->baseline >> 8;
+    int rise = level + ((sqi->envelope - sqi->baseline) >> 9) + 1;
+    if (!sqi->above && sample > rise) {
+        sqi->above = 1;
+        int64_t interval = sqi->position - sqi->last_rise;
+        if (sqi->last_rise < 0 || interval > (int64_t)(2.0f * sqi->sample_rate)) {
+            sqi->rises = 0;
+            sqi->interval_sum = 0;
+            sqi->interval_squares = 0;
+        } else {
+            sqi->interval_sum += interval;
+            sqi->interval_squares += interval * interval;
+        }
+        sqi->last_rise = sqi->position;
+        sqi->rises++;
+    } else if (sqi->above && sample < level) {
+        sqi->above = 0;
+    }
+    sqi->position++;
+    if (++sqi->count < sqi->block) {
+        return 0;
+    }
+    sqi->count = 0;
+    adc_ppg_sqi_settle(sqi);
+    return 1;
+}
+
+int adc_ppg_sqi_process(adc_ppg_sqi_t *sqi, const int *values, int length) {
+    int settled = 0;
+    for (int i = 0; i < length; i++) {
+        settled += adc_ppg_sqi_push(sqi, values[i]);
+    }
+    return settled;
+}
+
+//门控：返回1时值得跑心率/SpO2等重计算
+int adc_ppg_should_process(const adc_ppg_sqi_t *sqi) {
+    return sqi->open;
+}
+
+#ifndef ADC_BENCHMARK
+//写一个命令行流处理：从文件或stdin读原始ADC采样，按固定大小的块流式跑一串滤波，结果写到stdout
+//用法：test [-i 文件] [-f int16|uint16|int32|csv] [-o text|binary] [-w 窗口] [-s 步长] [-c 滤波链]
+//滤波链如 mean:16:16,median:5:1，每级为 名称[:窗口[:步长]]，省略时用-w/-s，后一级处理前一级的输出
+//可用滤波：mean median variance stddev threshold；binary输出为本机字节序int32
+//csv输入为逗号/空白分隔的整数，表头等非整数字段跳过，结束时在stderr报告跳过的个数
+//读文件由单独线程完成(双缓冲)，一块在解码处理时下一块已经在读，内存占用与文件大小无关
+#define ADC_CLI_CHUNK_BYTES (256 * 1024)
+#define ADC_CLI_MAX_STAGES 8
+
+typedef int (*adc_cli_filter_fn)(int *adc_values, int length);
+
+typedef struct {
+    adc_cli_filter_fn fn;
+    int window;
+    int stride;
+    int filled;     //buffer里已有的采样数
+    int skip;       //步长大于窗口时需要丢弃的采样数
+    int *buffer;
+    int *scratch;   //中值滤波会重排输入，每次都在副本上算
+} adc_cli_stage_t;
+
+typedef struct {
+    adc_cli_stage_t stages[ADC_CLI_MAX_STAGES];
+    int stage_count;
+    int binary_output;
+} adc_cli_chain_t;
+
+typedef struct {
+    FILE *input;
+    unsigned char *buffers[2];
+    size_t sizes[2];
+    int ready[2];   //1表示该块已读好等待处理
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} adc_cli_reader_t;
+
+static const struct {
+    const char *name;
+    adc_cli_filter_fn fn;
+} adc_cli_filters[] = {
+    {"mean", adc_mean_filter},
+    {"median", adc_median_filter},
+    {"variance", adc_variance_filter},
+    {"stddev", adc_standard_deviation_filter},
+    {"threshold", adaptive_threshold_algorithm},
+};
+
+static void adc_cli_usage(void) {
+    fprintf(stderr, "usage: test [-i file] [-f int16|uint16|int32|csv] [-o text|binary] [-w window] [-s stride] [-c filter[:window[:stride]],...]\n");
+}
+
+//读线程：轮流填两个缓冲，读到0字节表示结束
+static void *adc_cli_reader_thread(void *arg) {
+    adc_cli_reader_t *reader = arg;
+    for (int k = 0;; k ^= 1) {
+        pthread_mutex_lock(&reader->lock);
+        while (reader->ready[k]) {
+            pthread_cond_wait(&reader->changed, &reader->lock);
+        }
+        pthread_mutex_unlock(&reader->lock);
+        size_t size = fread(reader->buffers[k], 1, ADC_CLI_CHUNK_BYTES, reader->input);
+        pthread_mutex_lock(&reader->lock);
+        reader->sizes[k] = size;
+        reader->ready[k] = 1;
+        pthread_cond_broadcast(&reader->changed);
+        pthread_mutex_unlock(&reader->lock);
+        if (size == 0) {
+            return NULL;
+        }
+    }
+}
+
+static void adc_cli_write(adc_cli_chain_t *chain, int value) {
+    if (chain->binary_output) {
+        int32_t out = value;
+        fwrite(&out, sizeof(out), 1, stdout);
+    } else {
+        printf("%d\n", value);
+    }
+}
+
+//把一个采样送入第index级，窗口满了就算一次并送给下一级
+static void adc_cli_push(adc_cli_chain_t *chain, int index, int value) {
+    if (index == chain->stage_count) {
+        adc_cli_write(chain, value);
+        return;
+    }
+    adc_cli_stage_t *stage = &chain->stages[index];
+    if (stage->skip > 0) {
+        stage->skip--;
+        return;
+    }
+    stage->buffer[stage->filled++] = value;
+    if (stage->filled < stage->window) {
+        return;
+    }
+    memcpy(stage->scratch, stage->buffer, (size_t)stage->window * sizeof(int));
+    int result = stage->fn(stage->scratch, stage->window);
+    if (stage->stride < stage->window) {
+        stage->filled = stage->window - stage->stride;
+        memmove(stage->buffer, stage->buffer + stage->stride, (size_t)stage->filled * sizeof(int));
+    } else {
+        stage->filled = 0;
+        stage->skip = stage->stride - stage->window;
+    }
+    adc_cli_push(chain, index + 1, result);
+}
+
+//解析滤波链，每级 名称[:窗口[:步长]]
+static int adc_cli_parse_chain(adc_cli_chain_t *chain, const char *spec, int window, int stride) {
+    char text[256];
+    if (strlen(spec) >= sizeof(text)) {
+        return -1;
+    }
+    strcpy(text, spec);
+    for (char *save = NULL, *item = strtok_r(text, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save)) {
+        if (chain->stage_count == ADC_CLI_MAX_STAGES) {
+            return -1;
+        }
+        adc_cli_stage_t *stage = &chain->stages[chain->stage_count];
+        char *colon = strchr(item, ':');
+        stage->window = window;
+        stage->stride = stride;
+        if (colon != NULL) {
+            *colon = '\0';
+            stage->window = atoi(colon + 1);
+            char *second = strchr(colon + 1, ':');
+            stage->stride = second != NULL ? atoi(second + 1) : stage->window;
+        }
+        stage->fn = NULL;
+        for (size_t f = 0; f < sizeof(adc_cli_filters) / sizeof(adc_cli_filters[0]); f++) {
+            if (strcmp(item, adc_cli_filters[f].name) == 0) {
+                stage->fn = adc_cli_filters[f].fn;
+            }
+        }
+        if (stage->fn == NULL || stage->window < 1 || stage->stride < 1) {
+            fprintf(stderr, "bad filter stage '%s'\n", item);
+            return -1;
+        }
+        stage->buffer = malloc((size_t)stage->window * sizeof(int));
+        stage->scratch = malloc((size_t)stage->window * sizeof(int));
+        if (stage->buffer == NULL || stage->scratch == NULL) {
+            return -1;
+        }
+        chain->stage_count++;
+    }
+    return chain->stage_count > 0 ? 0 : -1;
+}
+
+//CSV解码：逗号、空白、换行分隔字段，每个字段必须整体是一个int32范围内的十进制整数(可带负号)
+//表头、小数等非整数字段和超出范围的数都跳过并计数，不会把半截数字送进滤波链
+typedef struct {
+    int in_field;   //当前字段已读到非分隔符
+    int digits;
+    int negative;
+    int invalid;
+    int64_t value;
+    int64_t skipped;
+} adc_cli_csv_t;
+
+static void adc_cli_csv_end_field(adc_cli_csv_t *csv, adc_cli_chain_t *chain) {
+    if (csv->in_field) {
+        if (csv->invalid || csv->digits == 0) {
+            csv->skipped++;
+        } else {
+            adc_cli_push(chain, 0, (int)(csv->negative ? -csv->value : csv->value));
+        }
+    }
+    csv->in_field = 0;
+    csv->digits = 0;
+    csv->negative = 0;
+    csv->invalid = 0;
+    csv->value = 0;
+}
+
+static void adc_cli_csv_feed(adc_cli_csv_t *csv, adc_cli_chain_t *chain, const unsigned char *data, size_t size) {
+    for (size_t pos = 0; pos < size; pos++) {
+        unsigned char c = data[pos];
+        if (c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            adc_cli_csv_end_field(csv, chain);
+            continue;
+        }
+        csv->in_field = 1;
+        if (csv->invalid) {
+            continue;
+        }
+        if (c >= '0' && c <= '9') {
+            csv->value = csv->value * 10 + (c - '0');
+            csv->digits++;
+            //负数可以到-2^31，超出int32范围的字段整个作废，value不会继续增长
+            if (csv->value > (int64_t)INT32_MAX + csv->negative) {
+                csv->invalid = 1;
+            }
+        } else if (c == '-' && csv->digits == 0 && !csv->negative) {
+            csv->negative = 1;
+        } else {
+            csv->invalid = 1;
+        }
+    }
+}
+
+int adc_cli_main(int argc, char **argv) {
+    const char *input_path = "-";
+    const char *format = "int16";
+    const char *chain_spec = "mean";
+    int window = 16;
+    int stride = 0;
+    adc_cli_chain_t chain;
+    memset(&chain, 0, sizeof(chain));
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc || argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0') {
+            adc_cli_usage();
+            return 2;
+        }
+        const char *value = argv[++i];
+        switch (argv[i - 1][1]) {
+        case 'i': input_path = value; break;
+        case 'f': format = value; break;
+        case 'o': chain.binary_output = strcmp(value, "binary") == 0; break;
+        case 'w': window = atoi(value); break;
+        case 's': stride = atoi(value); break;
+        case 'c': chain_spec = value; break;
+        default: adc_cli_usage(); return 2;
+        }
+    }
+    int sample_bytes = strcmp(format, "int16") == 0 || strcmp(format, "uint16") == 0 ? 2 : (strcmp(format, "int32") == 0 ? 4 : 0);
+    int csv = strcmp(format, "csv") == 0;
+    if (sample_bytes == 0 && !csv) {
+        adc_cli_usage();
+        return 2;
+    }
+    if (adc_cli_parse_chain(&chain, chain_spec, window, stride > 0 ? stride : window) != 0) {
+        adc_cli_usage();
+        return 2;
+    }
+    adc_cli_reader_t reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.input = strcmp(input_path, "-") == 0 ? stdin : fopen(input_path, "rb");
+    if (reader.input == NULL) {
+        perror(input_path);
+        return 1;
+    }
+    reader.buffers[0] = malloc(ADC_CLI_CHUNK_BYTES);
+    reader.buffers[1] = malloc(ADC_CLI_CHUNK_BYTES);
+    if (reader.buffers[0] == NULL || reader.buffers[1] == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    static char output_buffer[1 << 20];
+    setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+    pthread_mutex_init(&reader.lock, NULL);
+    pthread_cond_init(&reader.changed, NULL);
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, adc_cli_reader_thread, &reader) != 0) {
+        fprintf(stderr, "failed to start reader thread\n");
+        return 1;
+    }
+
+    //跨块的残留：二进制格式不满一个采样的字节，CSV格式未结束的字段
+    unsigned char carry[4];
+    int carry_bytes = 0;
+    adc_cli_csv_t csv_state;
+    memset(&csv_state, 0, sizeof(csv_state));
+    for (int k = 0;; k ^= 1) {
+        pthread_mutex_lock(&reader.lock);
+        while (!reader.ready[k]) {
+            pthread_cond_wait(&reader.changed, &reader.lock);
+        }
+        pthread_mutex_unlock(&reader.lock);
+        const unsigned char *data = reader.buffers[k];
+        size_t size = reader.sizes[k];
+        if (size == 0) {
+            break;
+        }
+        size_t pos = 0;
+        if (csv) {
+            adc_cli_csv_feed(&csv_state, &chain, data, size);
+        } else {
+            while (pos < size) {
+                while (carry_bytes < sample_bytes && pos < size) {
+                    carry[carry_bytes++] = data[pos++];
+                }
+                if (carry_bytes < sample_bytes) {
+                    break;
+                }
+                carry_bytes = 0;
+                int value;
+                if (sample_bytes == 4) {
+                    int32_t v;
+                    memcpy(&v, carry, 4);
+                    value = v;
+                } else if (format[0] == 'u') {
+                    uint16_t v;
+                    memcpy(&v, carry, 2);
+                    value = v;
+                } else {
+                    int16_t v;
+                    memcpy(&v, carry, 2);
+                    value = v;
+                }
+                adc_cli_push(&chain, 0, value);
+            }
+        }
+        pthread_mutex_lock(&reader.lock);
+        reader.ready[k] = 0;
+        pthread_cond_broadcast(&reader.changed);
+        pthread_mutex_unlock(&reader.lock);
+    }
+    if (csv) {
+        adc_cli_csv_end_field(&csv_state, &chain);
+        if (csv_state.skipped > 0) {
+            fprintf(stderr, "skipped %lld non-integer or out-of-range CSV fields\n", (long long)csv_state.skipped);
+        }
+    }
+    pthread_join(thread, NULL);
+    fflush(stdout);
+    int failed = ferror(reader.input) || ferror(stdout);
+    if (reader.input != stdin) {
+        fclose(reader.input);
+    }
+    for (int i = 0; i < chain.stage_count; i++) {
+        free(chain.stages[i].buffer);
+        free(chain.stages[i].scratch);
+    }
+    free(reader.buffers[0]);
+    free(reader.buffers[1]);
+    pthread_mutex_destroy(&reader.lock);
+    pthread_cond_destroy(&reader.changed);
+    return failed ? 1 : 0;
+}
+#endif
+
+#ifdef ADC_BENCHMARK
+//写一个基准测试：对adc_bench_cases里的滤波入口计时，尺寸8~16M采样 × 6种数据分布
+//包括6个基础滤波，以及经适配器计时的CIC、前缀和索引、级联盒式、批量接口和uint16_t/12位打包版本(格式转换不计时)
+//其余接口(多通道交织、免除法、二维块、流式状态类等)未计时，线程池的扩展性见--pool
+//编译：cc -O2 -DADC_BENCHMARK test.c -lm -lpthread
+//参数：--max-size N(最大尺寸) --quadratic-max N(O(n^2)函数的最大尺寸) --reps N(每个用例重复次数) --perf 1(硬件计数器)
+//      --pool 1(只跑线程池在不均匀负载下的扩展性测试)
+//输出每个用例的 ns/采样(最小/中位/均值±标准差)、每秒采样数、周期/采样(x86上为TSC参考周期)
+//打开--perf时在Linux上用perf_event_open额外统计IPC、分支预测失败率和每千采样的LLC缺失
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+typedef int (*adc_bench_fn)(int *adc_values, int length);
+typedef void (*adc_bench_prepare_fn)(int *work, const int *source, int length);
+
+typedef struct {
+    const char *name;
+    adc_bench_fn fn;
+    int quadratic;      //O(n^2)的函数，只跑到--quadratic-max
+    int mutates;        //会重排输入，每次重复前要恢复数据
+    adc_bench_prepare_fn prepare;   //把源数据转换成该函数的输入格式(不计时)，NULL表示直接拷贝int
+} adc_bench_case_t;
+
+//不是(int *, int)接口的函数用下面的适配器计时，需要的临时空间按最大尺寸增长后复用
+#define ADC_BENCH_RECORD_LENGTH 64
+
+static void *adc_bench_scratch(size_t bytes) {
+    static void *scratch;
+    static size_t capacity;
+    if (bytes > capacity) {
+        void *grown = realloc(scratch, bytes);
+        if (grown == NULL) {
+            fprintf(stderr, "out of memory for %zu scratch bytes\n", bytes);
+            exit(1);
+        }
+        scratch = grown;
+        capacity = bytes;
+    }
+    return scratch;
+}
+
+//uint16_t和12位打包格式就地写在work的前半部分，源数据都在12位范围内
+static void adc_bench_prepare_u16(int *work, const int *source, int length) {
+    uint16_t *values = (uint16_t *)work;
+    for (int i = 0; i < length; i++) {
+        values[i] = (uint16_t)source[i];
+    }
+}
+
+static void adc_bench_prepare_packed12(int *work, const int *source, int length) {
+    uint8_t *packed = (uint8_t *)work;
+    for (int i = 0; i < length; i += 2) {
+        int second = i + 1 < length ? source[i + 1] : 0;
+        packed[(size_t)(i >> 1) * 3] = (uint8_t)source[i];
+        packed[(size_t)(i >> 1) * 3 + 1] = (uint8_t)(((source[i] >> 8) & 0x0F) | ((second & 0x0F) << 4));
+        packed[(size_t)(i >> 1) * 3 + 2] = (uint8_t)(second >> 4);
+    }
+}
+
+static int adc_bench_mean_u16(int *work, int length) {
+    return adc_mean_filter_u16((const uint16_t *)work, length);
+}
+
+static int adc_bench_variance_u16(int *work, int length) {
+    return adc_variance_filter_u16((const uint16_t *)work, length);
+}
+
+static int adc_bench_median_u16(int *work, int length) {
+    return adc_median_filter_u16((uint16_t *)work, length);
+}
+
+static int adc_bench_mean_packed12(int *work, int length) {
+    return adc_mean_filter_packed12((const uint8_t *)work, length);
+}
+
+static int adc_bench_median_packed12(int *work, int length) {
+    return adc_median_filter_packed12((const uint8_t *)work, length, adc_bench_scratch((size_t)length * sizeof(uint16_t)));
+}
+
+//R=32、N=4，12位输入正好用满32位；输出就地写在work前部
+static int adc_bench_cic(int *work, int length) {
+    cic_decimator_t cic;
+    cic_decimator_init(&cic, 4, 32, 12);
+    int count = cic_decimator_process(&cic, work, length, work);
+    return count > 0 ? work[count - 1] : 0;
+}
+
+//超过ADC_PREFIX_MAX_LENGTH时按最大长度分段建索引，每段再查一次整段方差
+static int adc_bench_prefix_index(int *work, int length) {
+    int segment = length < ADC_PREFIX_MAX_LENGTH ? length : ADC_PREFIX_MAX_LENGTH;
+    int64_t *sums = adc_bench_scratch((size_t)(segment + 1) * 2 * sizeof(int64_t));
+    adc_prefix_index_t index;
+    int checksum = 0;
+    for (int start = 0; start < length; start += segment) {
+        int count = length - start < segment ? length - start : segment;
+        adc_prefix_index_build(&index, work + start, count, sums, sums + segment + 1);
+        checksum += adc_prefix_range_variance(&index, 0, count);
+    }
+    return checksum;
+}
+
+static int adc_bench_box_cascade(int *work, int length) {
+    static const int widths[3] = {16, 16, 16};
+    adc_box_filter_cascade(work, length, widths, 3, work);
+    return work[length / 2];
+}
+
+//把work切成ADC_BENCH_RECORD_LENGTH长的记录，每64条调用一次批量接口
+static int adc_bench_batch(const int *work, int length, int kind) {
+    adc_record_t records[64];
+    int results[64];
+    int scratch[ADC_BENCH_RECORD_LENGTH];
+    int checksum = 0;
+    for (int start = 0; start < length; start += 64 * ADC_BENCH_RECORD_LENGTH) {
+        int count = 0;
+        for (int offset = start; offset < length && count < 64; offset += ADC_BENCH_RECORD_LENGTH) {
+            records[count].values = work + offset;
+            records[count].length = length - offset < ADC_BENCH_RECORD_LENGTH ? length - offset : ADC_BENCH_RECORD_LENGTH;
+            count++;
+        }
+        if (kind == 0) {
+            adc_mean_filter_batch(records, count, results);
+        } else if (kind == 1) {
+            adc_variance_filter_batch(records, count, results);
+        } else {
+            adc_median_filter_batch(records, count, scratch, results);
+        }
+        checksum += results[count - 1];
+    }
+    return checksum;
+}
+
+static int adc_bench_mean_batch(int *work, int length) {
+    return adc_bench_batch(work, length, 0);
+}
+
+static int adc_bench_variance_batch(int *work, int length) {
+    return adc_bench_batch(work, length, 1);
+}
+
+static int adc_bench_median_batch(int *work, int length) {
+    return adc_bench_batch(work, length, 2);
+}
+
+static const adc_bench_case_t adc_bench_cases[] = {
+    {"mean", adc_mean_filter, 0, 0, NULL},
+    {"median", adc_median_filter, 1, 1, NULL},
+    {"variance", adc_variance_filter, 0, 0, NULL},
+    {"stddev", adc_standard_deviation_filter, 0, 0, NULL},
+    {"adaptive_threshold", adaptive_threshold_algorithm, 0, 0, NULL},
+    {"atgm336h_parser", atgm336h_satellite_parser, 0, 0, NULL},
+    {"cic_r32_n4", adc_bench_cic, 0, 1, NULL},
+    {"prefix_index", adc_bench_prefix_index, 0, 0, NULL},
+    {"box_cascade_3x16", adc_bench_box_cascade, 0, 1, NULL},
+    {"mean_batch", adc_bench_mean_batch, 0, 0, NULL},
+    {"variance_batch", adc_bench_variance_batch, 0, 0, NULL},
+    {"median_batch", adc_bench_median_batch, 0, 0, NULL},
+    {"mean_u16", adc_bench_mean_u16, 0, 0, adc_bench_prepare_u16},
+    {"variance_u16", adc_bench_variance_u16, 0, 0, adc_bench_prepare_u16},
+    {"median_u16", adc_bench_median_u16, 0, 1, adc_bench_prepare_u16},
+    {"mean_packed12", adc_bench_mean_packed12, 0, 0, adc_bench_prepare_packed12},
+    {"median_packed12", adc_bench_median_packed12, 0, 0, adc_bench_prepare_packed12},
+};
+
+//把源数据放进work，格式由用例决定
+static void adc_bench_prepare(const adc_bench_case_t *bench, int *work, const int *source, int length) {
+    if (bench->prepare != NULL) {
+        bench->prepare(work, source, length);
+    } else {
+        memcpy(work, source, (size_t)length * sizeof(int));
+    }
+}
+
+static const char *adc_bench_distributions[] = {"constant", "ramp", "noisy", "spiky", "sorted", "reverse"};
+
+#define ADC_BENCH_DISTRIBUTIONS (int)(sizeof(adc_bench_distributions) / sizeof(adc_bench_distributions[0]))
+#define ADC_BENCH_MAX_REPS 64
+
+static volatile int adc_bench_sink;
+
+//硬件计数器组，组长为cycles，其余计数器打不开时单独跳过；整组打不开(容器、无权限、非Linux)时只输出计时
+enum {
+    ADC_BENCH_PERF_CYCLES,
+    ADC_BENCH_PERF_INSTRUCTIONS,
+    ADC_BENCH_PERF_BRANCHES,
+    ADC_BENCH_PERF_BRANCH_MISSES,
+    ADC_BENCH_PERF_LLC_MISSES,
+    ADC_BENCH_PERF_COUNT
+};
+
+typedef struct {
+    int enabled;
+    int fds[ADC_BENCH_PERF_COUNT];
+    int slots[ADC_BENCH_PERF_COUNT];    //该计数器在组读取结果里的位置，-1表示不可用
+    int opened;
+    uint64_t totals[ADC_BENCH_PERF_COUNT];
+} adc_bench_perf_t;
+
+static adc_bench_perf_t adc_bench_perf;
+
+static void adc_bench_perf_open(void) {
+    memset(&adc_bench_perf, 0, sizeof(adc_bench_perf));
+    for (int i = 0; i < ADC_BENCH_PERF_COUNT; i++) {
+        adc_bench_perf.fds[i] = -1;
+        adc_bench_perf.slots[i] = -1;
+    }
+#if defined(__linux__)
+    static const uint64_t configs[ADC_BENCH_PERF_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+        PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES,
+    };
+    for (int i = 0; i < ADC_BENCH_PERF_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.disabled = i == 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        int leader = adc_bench_perf.fds[ADC_BENCH_PERF_CYCLES];
+        int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : leader, 0);
+        if (fd < 0) {
+            if (i == 0) {
+                fprintf(stderr, "perf_event_open unavailable, reporting timings only\n");
+                return;
+            }
+            continue;
+        }
+        adc_bench_perf.fds[i] = fd;
+        adc_bench_perf.slots[i] = adc_bench_perf.opened++;
+    }
+    adc_bench_perf.enabled = 1;
+#endif
+}
+
+static void adc_bench_perf_close(void) {
+#if defined(__linux__)
+    for (int i = 0; i < ADC_BENCH_PERF_COUNT; i++) {
+        if (adc_bench_perf.fds[i] >= 0) {
+            close(adc_bench_perf.fds[i]);
+        }
+    }
+#endif
+    adc_bench_perf.enabled = 0;
+}
+
+static void adc_bench_perf_start(void) {
+#if defined(__linux__)
+    if (adc_bench_perf.enabled) {
+        int leader = adc_bench_perf.fds[ADC_BENCH_PERF_CYCLES];
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+}
+
+//停止计数并把本次结果累加到totals
+static void adc_bench_perf_stop(void) {
+#if defined(__linux__)
+    if (adc_bench_perf.enabled) {
+        uint64_t values[1 + ADC_BENCH_PERF_COUNT];
+        int leader = adc_bench_perf.fds[ADC_BENCH_PERF_CYCLES];
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        if (read(leader, values, sizeof(values)) < (ssize_t)sizeof(uint64_t)) {
+            return;
+        }
+        for (int i = 0; i < ADC_BENCH_PERF_COUNT; i++) {
+            if (adc_bench_perf.slots[i] >= 0 && (uint64_t)adc_bench_perf.slots[i] < values[0]) {
+                adc_bench_perf.totals[i] += values[1 + adc_bench_perf.slots[i]];
+            }
+        }
+    }
+#endif
+}
+
+//打印IPC、分支预测失败率、每千采样LLC缺失，不可用的计数器打印n/a
+static void adc_bench_perf_print(double samples) {
+    const uint64_t *totals = adc_bench_perf.totals;
+    const int *slots = adc_bench_perf.slots;
+    if (slots[ADC_BENCH_PERF_INSTRUCTIONS] >= 0 && totals[ADC_BENCH_PERF_CYCLES] > 0) {
+        printf(" %6.2f", (double)totals[ADC_BENCH_PERF_INSTRUCTIONS] / totals[ADC_BENCH_PERF_CYCLES]);
+    } else {
+        printf(" %6s", "n/a");
+    }
+    if (slots[ADC_BENCH_PERF_BRANCHES] >= 0 && slots[ADC_BENCH_PERF_BRANCH_MISSES] >= 0 && totals[ADC_BENCH_PERF_BRANCHES] > 0) {
+        printf(" %9.3f%%", 100.0 * totals[ADC_BENCH_PERF_BRANCH_MISSES] / totals[ADC_BENCH_PERF_BRANCHES]);
+    } else {
+        printf(" %10s", "n/a");
+    }
+    if (slots[ADC_BENCH_PERF_LLC_MISSES] >= 0) {
+        printf(" %12.3f", 1000.0 * totals[ADC_BENCH_PERF_LLC_MISSES] / samples);
+    } else {
+        printf(" %12s", "n/a");
+    }
+}
+
+static uint64_t adc_bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t adc_bench_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+//生成12位ADC范围内的测试数据，伪随机数用固定种子的LCG保证每次运行一致
+static void adc_bench_fill(int *values, int length, int distribution) {
+    uint32_t seed = 12345u;
+    for (int i = 0; i < length; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        int noise = (int)(seed >> 23) - 256;
+        switch (distribution) {
+        case 0: values[i] = 2048; break;
+        case 1: values[i] = i & 4095; break;
+        case 2: values[i] = 2048 + noise; break;
+        case 3: values[i] = (seed >> 16) % 97 == 0 ? 4095 : 2048 + noise / 16; break;
+        case 4: values[i] = (int)((int64_t)i * 4095 / length); break;
+        default: values[i] = 4095 - (int)((int64_t)i * 4095 / length); break;
+        }
+    }
+}
+
+static int adc_bench_compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+//跑一个用例：先预热，再重复reps次，每次单独计时
+//小尺寸时一次计时内连续调用batch次(各自作用在work里的一份独立拷贝上)，避免计时开销淹没结果
+static void adc_bench_run_case(const adc_bench_case_t *bench, const char *distribution, const int *source, int *work, int length, int batch, int reps) {
+    double ns_per_sample[ADC_BENCH_MAX_REPS];
+    double cycles_total = 0;
+    double mean = 0;
+    double deviation = 0;
+    memset(adc_bench_perf.totals, 0, sizeof(adc_bench_perf.totals));
+    for (int warmup = 0; warmup < 2; warmup++) {
+        adc_bench_prepare(bench, work, source, length);
+        adc_bench_sink = bench->fn(work, length);
+    }
+    for (int r = 0; r < reps; r++) {
+        if (bench->mutates || r == 0) {
+            for (int b = 0; b < batch; b++) {
+                adc_bench_prepare(bench, work + (size_t)b * length, source, length);
+            }
+        }
+        adc_bench_perf_start();
+        uint64_t cycles_start = adc_bench_cycles();
+        uint64_t start = adc_bench_now_ns();
+        for (int b = 0; b < batch; b++) {
+            adc_bench_sink = bench->fn(work + (size_t)b * length, length);
+        }
+        uint64_t elapsed = adc_bench_now_ns() - start;
+        cycles_total += (double)(adc_bench_cycles() - cycles_start);
+        adc_bench_perf_stop();
+        ns_per_sample[r] = (double)elapsed / ((double)length * batch);
+        mean += ns_per_sample[r];
+    }
+    mean /= reps;
+    for (int r = 0; r < reps; r++) {
+        deviation += (ns_per_sample[r] - mean) * (ns_per_sample[r] - mean);
+    }
+    deviation = reps > 1 ? sqrt(deviation / (reps - 1)) : 0;
+    qsort(ns_per_sample, (size_t)reps, sizeof(double), adc_bench_compare_double);
+    double median = ns_per_sample[reps / 2];
+    printf("%-20s %-9s %9d %5d %10.3f %10.3f %10.3f %8.3f %12.2f %10.3f",
+           bench->name, distribution, length, reps, ns_per_sample[0], median, mean, deviation,
+           median > 0 ? 1e3 / median : 0.0, cycles_total / reps / ((double)length * batch));
+    if (adc_bench_perf.enabled) {
+        adc_bench_perf_print((double)length * batch * reps);
+    }
+    printf("\n");
+}
+
+//线程池扩展性测试：模拟ADC_BENCH_DEVICES台设备，每台的记录数很不均匀(前1/16的设备是普通设备的8~40倍，
+//像按型号排序的设备列表那样集中在一起)
+//对比按线程静态平分设备和工作窃取线程池两种方式在不同线程数下的耗时
+#define ADC_BENCH_DEVICES 512
+
+typedef struct {
+    const int *samples;
+    int records;
+    int result;
+} adc_bench_device_t;
+
+static void adc_bench_device_task(void *arg) {
+    adc_bench_device_t *device = arg;
+    adc_record_t batch[64];
+    int results[64];
+    int scratch[ADC_BENCH_RECORD_LENGTH];
+    int checksum = 0;
+    for (int start = 0; start < device->records; start += 64) {
+        int count = device->records - start < 64 ? device->records - start : 64;
+        for (int r = 0; r < count; r++) {
+            batch[r].values = device->samples + (size_t)(start + r) * ADC_BENCH_RECORD_LENGTH;
+            batch[r].length = ADC_BENCH_RECORD_LENGTH;
+        }
+        adc_variance_filter_batch(batch, count, results);
+        checksum += results[0];
+        adc_median_filter_batch(batch, count, scratch, results);
+        checksum += results[count - 1];
+    }
+    device->result = checksum;
+}
+
+typedef struct {
+    adc_bench_device_t *devices;
+    int begin;
+    int end;
+} adc_bench_static_job_t;
+
+static void *adc_bench_static_worker(void *arg) {
+    adc_bench_static_job_t *job = arg;
+    for (int d = job->begin; d < job->end; d++) {
+        adc_bench_device_task(&job->devices[d]);
+    }
+    return NULL;
+}
+
+static int adc_bench_pool_scaling(void) {
+    static adc_bench_device_t devices[ADC_BENCH_DEVICES];
+    int total_records = 0;
+    for (int d = 0; d < ADC_BENCH_DEVICES; d++) {
+        devices[d].records = d < ADC_BENCH_DEVICES / 16 ? 2000 : 50 * (1 + d % 5);
+        total_records += devices[d].records;
+    }
+    int *samples = malloc((size_t)total_records * ADC_BENCH_RECORD_LENGTH * sizeof(int));
+    if (samples == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    adc_bench_fill(samples, total_records * ADC_BENCH_RECORD_LENGTH, 2);
+    for (int d = 0, offset = 0; d < ADC_BENCH_DEVICES; d++) {
+        devices[d].samples = samples + (size_t)offset * ADC_BENCH_RECORD_LENGTH;
+        offset += devices[d].records;
+    }
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = online > 1 ? (int)online : 2;
+    if (max_threads > ADC_MAX_THREADS) {
+        max_threads = ADC_MAX_THREADS;
+    }
+    printf("%d devices, %d records of %d samples, uneven load (max/min records %d)\n",
+           ADC_BENCH_DEVICES, total_records, ADC_BENCH_RECORD_LENGTH, 2000 / 50);
+    printf("%8s %12s %12s %10s %10s\n", "threads", "static ms", "stealing ms", "speedup", "vs static");
+    double baseline = 0;
+    for (int threads = 1; threads <= max_threads; threads = threads * 2 > max_threads && threads < max_threads ? max_threads : threads * 2) {
+        pthread_t handles[ADC_MAX_THREADS];
+        adc_bench_static_job_t jobs[ADC_MAX_THREADS];
+        int started[ADC_MAX_THREADS];
+        uint64_t start = adc_bench_now_ns();
+        for (int t = 0; t < threads; t++) {
+            jobs[t].devices = devices;
+            jobs[t].begin = ADC_BENCH_DEVICES * t / threads;
+            jobs[t].end = ADC_BENCH_DEVICES * (t + 1) / threads;
+            started[t] = pthread_create(&handles[t], NULL, adc_bench_static_worker, &jobs[t]) == 0;
+        }
+        for (int t = 0; t < threads; t++) {
+            if (started[t]) {
+                pthread_join(handles[t], NULL);
+            } else {
+                adc_bench_static_worker(&jobs[t]);
+            }
+        }
+        double static_ms = (double)(adc_bench_now_ns() - start) / 1e6;
+
+        adc_task_pool_t *pool = adc_task_pool_create(threads);
+        if (pool == NULL) {
+            free(samples);
+            return 1;
+        }
+        adc_task_group_t group;
+        adc_task_group_init(&group);
+        start = adc_bench_now_ns();
+        for (int d = 0; d < ADC_BENCH_DEVICES; d++) {
+            adc_task_pool_submit(pool, &group, adc_bench_device_task, &devices[d]);
+        }
+        adc_task_pool_wait(pool, &group);
+        double pool_ms = (double)(adc_bench_now_ns() - start) / 1e6;
+        adc_task_pool_destroy(pool);
+        if (threads == 1) {
+            baseline = pool_ms;
+        }
+        printf("%8d %12.2f %12.2f %9.2fx %9.2fx\n", threads, static_ms, pool_ms, baseline / pool_ms, static_ms / pool_ms);
+        if (threads == max_threads) {
+            break;
+        }
+    }
+    free(samples);
+    return 0;
+}
+
+int adc_benchmark_main(int argc, char **argv) {
+    int max_size = 16 * 1024 * 1024;
+    int quadratic_max = 8192;
+    int reps_override = 0;
+    int perf = 0;
+    int pool_scaling = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--max-size") == 0) {
+            max_size = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--quadratic-max") == 0) {
+            quadratic_max = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--reps") == 0) {
+            reps_override = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            perf = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--pool") == 0) {
+            pool_scaling = atoi(argv[i + 1]);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (pool_scaling) {
+        return adc_bench_pool_scaling();
+    }
+    if (max_size < 8) {
+        max_size = 8;
+    }
+    int *source = malloc((size_t)max_size * sizeof(int));
+    int *work = malloc((size_t)max_size * sizeof(int));
+    if (source == NULL || work == NULL) {
+        fprintf(stderr, "out of memory for %d samples\n", max_size);
+        free(source);
+        free(work);
+        return 1;
+    }
+    int mismatches = adc_dispatch_self_check();
+    printf("simd level: %s (set ADC_SIMD_LEVEL to override), kernel self-check mismatches: %d\n", adc_dispatch_level(), mismatches);
+    if (mismatches != 0) {
+        free(source);
+        free(work);
+        return 1;
+    }
+    if (perf) {
+        adc_bench_perf_open();
+    }
+    printf("%-20s %-9s %9s %5s %10s %10s %10s %8s %12s %10s",
+           "function", "data", "samples", "reps", "ns/s min", "ns/s med", "ns/s mean", "stddev", "Msamples/s", "cyc/sample");
+    if (adc_bench_perf.enabled) {
+        printf(" %6s %10s %12s", "IPC", "br-miss", "LLC/1k");
+    }
+    printf("\n");
+    //尺寸按4倍递增，最后一档补到max_size
+    for (int length = 8; length <= max_size; length = (length < max_size && length * 4 > max_size) ? max_size : length * 4) {
+        //小尺寸多跑几次让总时间稳定，大尺寸少跑
+        int reps = reps_override > 0 ? reps_override : (length <= 65536 ? 32 : (length <= 1048576 ? 10 : 5));
+        if (reps > ADC_BENCH_MAX_REPS) {
+            reps = ADC_BENCH_MAX_REPS;
+        }
+        int batch = length < 4096 ? 4096 / length : 1;
+        if ((int64_t)batch * length > max_size) {
+            batch = max_size / length;
+        }
+        for (int d = 0; d < ADC_BENCH_DISTRIBUTIONS; d++) {
+            adc_bench_fill(source, length, d);
+            for (size_t c = 0; c < sizeof(adc_bench_cases) / sizeof(adc_bench_cases[0]); c++) {
+                if (adc_bench_cases[c].quadratic && length > quadratic_max) {
+                    continue;
+                }
+                adc_bench_run_case(&adc_bench_cases[c], adc_bench_distributions[d], source, work, length, batch, reps);
+            }
+        }
+        if (length == max_size) {
+            break;
+        }
+    }
+    adc_bench_perf_close();
+    free(source);
+    free(work);
+    return 0;
+}
+#endif